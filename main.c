@@ -1,7 +1,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "solver.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define isDigit(a) (a >= '0' && a <= '9')
 #define isLetter(a) (a >= 'a' && a <= 'z' || a >= 'A' && a <= 'Z')
@@ -15,6 +31,13 @@
 #define B 211867L
 #define SEED 74395212
 
+#define FROZEN_BUCKET_LOAD 4 /* average names in bucket of frozen name table */
+#define FROZEN_MAX_DISPLACEMENT 0x100000 /* tries for one bucket before new seed is chosen */
+#define FROZEN_ATTEMPTS 16 /* seeds tried before frozen name table gives up */
+
+#define PARSE_CHUNK_LINES 4096 /* students section is parsed on threads only if it has more lines */
+#define MAX_THREADS 64
+
 #define MAX_COURSES 100
 #define MAX_STUDENTS 1000
 
@@ -49,13 +72,84 @@
 #define P_SURNAME 1
 #define P_COURSES 2
 
+/*
+ * Default sizes of genetic algorithm, can be changed at runtime (see config_t).
+ */
 #define POPULATION_SIZE 10000
 #define KIDS_SIZE 1250
 #define BEST_SIZE 50
 #define MUTATION_SIZE 1200
 #define GENERATIONS_NUMBER 0
+#define GREEDY_PERCENT 10 /* percent of population zero built by greedy_genome */
+
+#define PROBE_SIZE 64 /* individuals created by auto-tuner to measure their cost */
+#define MIN_POPULATION_SIZE 100
+#define MAX_POPULATION_SIZE 1000000
+#define MAX_GENERATIONS_NUMBER 1000
+#define OUTPUT_SECONDS_PER_STUDENT 1e-6 /* time reserved for output of one student */
+#define DEFAULT_TIME_BUDGET 1.0 /* CPU seconds used by auto-tuner when no budget is given */
+
+#define MAX_BADNESS_POINTS 1000000000 /* more than any possible individual can get */
+
+#define SOA_LANES 4 /* individuals scored by one vector instruction */
+#define SOA_BLOCK 256 /* individuals scored by one call of calculate_badness_batch */
+
+#define CACHE_SIZE 0x10000 /* 65536, must be a power of two */
+#define CACHE_PROBES 8 /* slots checked before an old entry is overwritten */
+
+/*
+ * Penalty components used as separate objectives in multi-objective mode.
+ */
+#define OBJ_COURSES 0 /* courses that cannot be run */
+#define OBJ_PROFS 1 /* lacking prof slots */
+#define OBJ_TAS 2 /* idle TA labs */
+#define OBJ_STUDENTS 3 /* students over course capacity */
+#define OBJECTIVES 4
+#define ARCHIVE_SIZE 1024 /* maximum number of individuals on Pareto front */
+#define FRONT_NAME_SIZE 40
+
+#define GENE_NONE8 0xFF /* missing id in genome with uint8_t ids */
+#define GENE_NONE16 0xFFFF /* missing id in genome with uint16_t ids */
+
+#define CHECKPOINT_MAGIC 0x4b434841 /* "AHCK" */
+#define CHECKPOINT_VERSION 4
+#define CHECKPOINT_NAME_SIZE 40
+#define STREAM_NAME_SIZE 40
+
+#define DELTA_MUTANTS 63 /* mutants of kept solution scored in one round of re-optimization */
+#define DELTA_ROUNDS 20
+#define POLISH_ROUNDS 20 /* rounds of local search after solutions of components are merged */
+#define MIN_PART_POPULATION 100 /* smallest population of one component */
+#define DELTA_NAME_SIZE 64
+
+#define TOURNAMENT_SIZE 16 /* members compared by one tournament of steady-state search */
+#define STEADY_LOCKS 64 /* locks of population in steady-state search, must be a power of two */
+#define STEADY_CHUNK 64 /* steps a thread of steady-state search takes at once */
+
+#define DIVERSITY_PAIRS 32 /* pairs of parents compared to measure diversity of population */
+#define DIVERSITY_LOW 0.05 /* share of different genes below which mutants and parents are added */
+#define DIVERSITY_HIGH 0.25 /* share of different genes above which mutants and parents are removed */
+
+/*
+ * Strategies raced by portfolio solver (see get_portfolio_sol); lane k runs strategy k % PORTFOLIO_STRATEGIES.
+ */
+#define STRATEGY_GENERATIONS 0 /* generations of get_best_sol */
+#define STRATEGY_STEADY 1 /* steady-state search */
+#define STRATEGY_LOCAL 2 /* local search from greedy genome */
+#define STRATEGY_COMPONENTS 3 /* independent groups of courses solved one after another */
+#define PORTFOLIO_STRATEGIES 4
 
-#define MAX_BADNESS_POINTS 30000
+/*
+ * Phases of solving one input measured by hardware counters (see perf_phase).
+ */
+#define PHASE_PARSE 0 /* reading of input or change list */
+#define PHASE_POOLS 1 /* pools of qualified people and students of courses */
+#define PHASE_GENERATION 2 /* breeding and scoring of genomes */
+#define PHASE_SELECTION 3 /* choice of parents */
+#define PHASE_SEARCH 4 /* the rest of search: bounds, components, repair, decoding */
+#define PHASE_OUTPUT 5 /* writing of output */
+#define PHASES 6
+#define PERF_COUNTERS 4 /* cycles, instructions, cache misses, branch misses */
 
 
 /*
@@ -97,6 +191,13 @@ int maximum(int a, int b) {
     return a > b ? a : b;
 }
 
+/*
+ * Returns minimum value of 2 integers.
+ */
+int minimum(int a, int b) {
+    return a < b ? a : b;
+}
+
 /*
  * Compare two strings. If they are equal to each other: 0; otherwise: 1
  */
@@ -113,6 +214,184 @@ int compare_str(const char *a, const char *b) {
 }
 
 
+/*
+ * Mixing function of splitmix64 generator, spreads bits of x over the whole value.
+ */
+unsigned long long mix64(unsigned long long x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/*
+ * 64-bit FNV-1a hash of string, used by frozen name tables.
+ */
+unsigned long long name_hash(const char *string) {
+    unsigned long long value = 0xcbf29ce484222325ULL;
+
+    for (; *string != '\0'; ++string) {
+        value ^= (unsigned char) *string;
+        value *= 0x100000001b3ULL;
+    }
+
+    return value;
+}
+
+/*
+ * Minimal perfect hash of a set of names that does not change any more (hash and displace).
+ * Name is hashed once; high bits choose its bucket, and the bucket's displacement
+ * moves all names of the bucket into free slots, so every slot has exactly one name.
+ * Finding a name costs one hash and one comparison.
+ */
+typedef struct frozen_names_s {
+    int size; // number of names and slots
+    int buckets;
+    unsigned long long seed;
+    unsigned *displacement; // displacement[b] of bucket b
+    int *ids; // ids[slot] = id of name in slot
+    char **names; // names[slot] = name in slot
+} fnames_t;
+
+/*
+ * Bucket of name with hash h.
+ */
+int frozen_bucket(const fnames_t *frozen, unsigned long long h) {
+    return (int) ((h >> 32) % (unsigned) frozen -> buckets);
+}
+
+/*
+ * Slot of name with hash h when its bucket has displacement d.
+ */
+int frozen_slot(const fnames_t *frozen, unsigned long long h, unsigned d) {
+    return (int) (mix64(h ^ (d * 0x9e3779b97f4a7c15ULL)) % (unsigned) frozen -> size);
+}
+
+/*
+ * Compare function for qsort of hashes.
+ */
+int compare_hashes(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *) a, y = *(const unsigned long long *) b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Free space that was used by frozen names. Names are owned by their structures.
+ */
+void free_frozen_names(fnames_t *frozen) {
+    free(frozen -> displacement);
+    free(frozen -> ids);
+    free(frozen -> names);
+    free(frozen);
+}
+
+/*
+ * Find displacements of all buckets for hashes of names.
+ * Buckets are placed from the largest one. If any error (too many tries) -> return 1.
+ */
+int place_buckets(fnames_t *frozen, int n, const unsigned long long *hashes) {
+    int *start = calloc((size_t) frozen -> buckets + 1, sizeof(int));
+    int *members = malloc(n * sizeof(int)); // names sorted by bucket
+    int *slots = malloc(n * sizeof(int));
+    unsigned long long *order = malloc(frozen -> buckets * sizeof(unsigned long long)); // size << 32 | bucket
+    int error = 0;
+
+    for (int k = 0; k < n; ++k) {
+        start[frozen_bucket(frozen, hashes[k]) + 1]++;
+    }
+    for (int b = 0; b < frozen -> buckets; ++b) {
+        order[b] = ((unsigned long long) start[b + 1] << 32) | (unsigned) b;
+        start[b + 1] += start[b];
+    }
+    int *fill = calloc((size_t) frozen -> buckets, sizeof(int));
+    for (int k = 0; k < n; ++k) {
+        int b = frozen_bucket(frozen, hashes[k]);
+        members[start[b] + fill[b]++] = k;
+    }
+    free(fill);
+    qsort(order, frozen -> buckets, sizeof(unsigned long long), compare_hashes);
+
+    for (int o = frozen -> buckets - 1; o >= 0 && !error; --o) {
+        int b = (int) (order[o] & 0xffffffffu), size = (int) (order[o] >> 32);
+        if (size == 0) break;
+
+        unsigned d = 0;
+        for (; d < FROZEN_MAX_DISPLACEMENT; ++d) {
+            int ok = 1;
+            for (int m = 0; m < size && ok; ++m) {
+                slots[m] = frozen_slot(frozen, hashes[members[start[b] + m]], d);
+                ok = frozen -> ids[slots[m]] == -1;
+                for (int l = 0; l < m && ok; ++l) {
+                    ok = slots[l] != slots[m];
+                }
+            }
+            if (ok) break;
+        }
+
+        if (d == FROZEN_MAX_DISPLACEMENT) {
+            error = 1;
+            break;
+        }
+        frozen -> displacement[b] = d;
+        for (int m = 0; m < size; ++m) {
+            frozen -> ids[slots[m]] = members[start[b] + m];
+        }
+    }
+
+    free(order);
+    free(slots);
+    free(members);
+    free(start);
+    return error;
+}
+
+/*
+ * Build minimal perfect hash of n different names, id of names[k] is k.
+ * Returns NULL if it cannot be built (it happens only if names are not different).
+ */
+fnames_t *freeze_names(int n, char **names) {
+    fnames_t *frozen = malloc(sizeof(fnames_t));
+    unsigned long long *hashes = malloc((n + 1) * sizeof(unsigned long long));
+
+    frozen -> size = maximum(n, 1);
+    frozen -> buckets = n / FROZEN_BUCKET_LOAD + 1;
+    frozen -> displacement = calloc((size_t) frozen -> buckets, sizeof(unsigned));
+    frozen -> ids = malloc(frozen -> size * sizeof(int));
+    frozen -> names = calloc((size_t) frozen -> size, sizeof(char *));
+
+    int error = 1;
+    for (int attempt = 0; attempt < FROZEN_ATTEMPTS && error; ++attempt) {
+        frozen -> seed = mix64((unsigned long long) attempt + 1);
+        for (int k = 0; k < n; ++k) {
+            hashes[k] = mix64(name_hash(names[k]) ^ frozen -> seed);
+        }
+        for (int s = 0; s < frozen -> size; ++s) {
+            frozen -> ids[s] = -1;
+        }
+        error = place_buckets(frozen, n, hashes);
+    }
+    free(hashes);
+
+    if (error) {
+        free_frozen_names(frozen);
+        return NULL;
+    }
+
+    for (int s = 0; s < frozen -> size; ++s) {
+        if (frozen -> ids[s] != -1) frozen -> names[s] = names[frozen -> ids[s]];
+    }
+    return frozen;
+}
+
+/*
+ * Get id of name from frozen names. If there is no such name: -1
+ */
+int frozen_find(const fnames_t *frozen, const char *name) {
+    unsigned long long h = mix64(name_hash(name) ^ frozen -> seed);
+    int slot = frozen_slot(frozen, h, frozen -> displacement[frozen_bucket(frozen, h)]);
+
+    return frozen -> names[slot] != NULL && !compare_str(frozen -> names[slot], name) ? frozen -> ids[slot] : -1;
+}
+
 typedef struct professor_s {
     int id;
     char *name;
@@ -125,12 +404,25 @@ typedef struct ta_s {
     int *courses;
 } ta_t;
 
-typedef struct student_s {
-    int id;
-    char *name;
-    char *code;
-    int *courses;
-} student_t;
+/*
+ * All students in compressed sparse rows: courses of student k are
+ * course_ids[first[k]] .. course_ids[first[k] + count[k] - 1], their name ("Name Surname") and code
+ * are strings ended by zero at text + name[k] and text + code[k].
+ * Students read from input lie one after another in both pools, so passes over enrollments scan memory in order.
+ * A student who gets new courses from change list is moved to the end of course_ids.
+ */
+typedef struct roster_s {
+    int S;
+    int capacity; // students that fit into arrays
+    int *first;
+    int *count;
+    size_t *name;
+    size_t *code;
+    int *course_ids;
+    int ids_size, ids_capacity;
+    char *text; // string pool
+    size_t text_size, text_capacity;
+} roster_t;
 
 typedef struct course_s {
     int id;
@@ -145,6 +437,7 @@ typedef struct course_s {
  */
 typedef struct courses_hashtable_s {
     course_t **courses;
+    fnames_t *frozen; // perfect hash of courses, built when courses section ends (see freezeCoursesHashTable)
 } chash_t;
 
 /*
@@ -179,6 +472,7 @@ typedef struct course_ind {
     course_t *course;
     professor_t *prof; // assigned prof
     int ta_number;
+    int ta_capacity; // TAs allocated in tas, they are kept when individual is reused
     ta_c_t **tas;
 } cind_t;
 
@@ -187,9 +481,38 @@ typedef struct course_ind {
  */
 typedef struct individual {
     int badness_points;
+    unsigned long long hash; // canonical hash of assignment (see ind_hash)
     cind_t **cinds;
 } ind_t;
 
+/*
+ * Parameters of solver that can be changed at runtime.
+ */
+typedef struct solver_config_s {
+    int population_size;
+    int best_size; // individuals that survive a generation
+    int kids_size; // children of best individuals in a generation
+    int mutation_size; // mutants of best individuals in a generation
+    int generations_number;
+    double time_budget; // CPU seconds for one input, 0 - unlimited
+    int auto_tune; // choose sizes from instance size and time budget
+    int print_stats; // print stats into standard error
+    int write_front; // write Pareto front of every input
+    double checkpoint_seconds; // CPU seconds between checkpoints, 0 - no checkpoints
+    int resume; // continue from checkpoint of input if there is one
+    int write_stream; // write every improvement of the best individual of every input
+    int threads; // threads used by parallel parts, 0 - number of processors
+    int delta; // apply change lists input<i>.delta<k>.txt after input<i>.txt
+    int delta_rounds; // rounds of local search after change list
+    int split; // solve groups of courses that share no qualified people separately
+    int steady; // steady-state search instead of generations
+    int tournament_size; // members compared by one tournament of steady-state search
+    int adapt; // change mutants and parents of generations by diversity of parents
+    int greedy_percent; // percent of population zero built by greedy_genome, the rest is random
+    int profile; // count hardware events of phases of every input and print them into standard error
+    int portfolio; // race strategies on all threads and take the best solution
+} config_t;
+
 
 /*
  * Default creator of professor
@@ -256,25 +579,183 @@ void print_course(course_t *course) {
 }
 
 /*
- * Create new student.
+ * Create empty roster of students.
+ */
+roster_t *create_roster() {
+    return calloc(1, sizeof(roster_t));
+}
+
+/*
+ * Free space that was used by roster.
+ */
+void free_roster(roster_t *roster) {
+    free(roster -> first);
+    free(roster -> count);
+    free(roster -> name);
+    free(roster -> code);
+    free(roster -> course_ids);
+    free(roster -> text);
+    free(roster);
+}
+
+/*
+ * Start new student roster -> S without courses, name and code. They are counted by roster_end.
+ */
+void roster_begin(roster_t *roster) {
+    int k = roster -> S;
+
+    if (k == roster -> capacity) {
+        roster -> capacity = roster -> capacity ? 2 * roster -> capacity : 64;
+        roster -> first = realloc(roster -> first, roster -> capacity * sizeof(int));
+        roster -> count = realloc(roster -> count, roster -> capacity * sizeof(int));
+        roster -> name = realloc(roster -> name, roster -> capacity * sizeof(size_t));
+        roster -> code = realloc(roster -> code, roster -> capacity * sizeof(size_t));
+    }
+
+    roster -> first[k] = roster -> ids_size;
+    roster -> count[k] = 0;
+    roster -> name[k] = roster -> code[k] = roster -> text_size;
+}
+
+/*
+ * Count student started by roster_begin.
+ */
+void roster_end(roster_t *roster) {
+    roster -> S++;
+}
+
+/*
+ * Append size characters of str and then end to string pool.
+ */
+void roster_put_text(roster_t *roster, const char *str, size_t size, char end) {
+    if (roster -> text_size + size + 1 > roster -> text_capacity) {
+        roster -> text_capacity = 2 * (roster -> text_size + size + 1);
+        roster -> text = realloc(roster -> text, roster -> text_capacity);
+    }
+
+    memcpy(roster -> text + roster -> text_size, str, size);
+    roster -> text_size += size;
+    roster -> text[roster -> text_size++] = end;
+}
+
+/*
+ * Set code of started student.
+ */
+void roster_put_code(roster_t *roster, const char *code) {
+    roster -> code[roster -> S] = roster -> text_size;
+    roster_put_text(roster, code, strlen(code), '\0');
+}
+
+/*
+ * Append course to the end of course_ids.
+ */
+void roster_push_id(roster_t *roster, int course) {
+    if (roster -> ids_size == roster -> ids_capacity) {
+        roster -> ids_capacity = roster -> ids_capacity ? 2 * roster -> ids_capacity : 256;
+        roster -> course_ids = realloc(roster -> course_ids, roster -> ids_capacity * sizeof(int));
+    }
+    roster -> course_ids[roster -> ids_size++] = course;
+}
+
+/*
+ * Add course to started student.
+ */
+void roster_put_course(roster_t *roster, int course) {
+    roster_push_id(roster, course);
+    roster -> count[roster -> S]++;
+}
+
+/*
+ * Name of student k ("Name Surname").
+ */
+char *roster_name(const roster_t *roster, int k) {
+    return roster -> text + roster -> name[k];
+}
+
+/*
+ * Code of student k.
+ */
+char *roster_code(const roster_t *roster, int k) {
+    return roster -> text + roster -> code[k];
+}
+
+/*
+ * Courses of student k, roster -> count[k] of them.
+ */
+int *roster_courses(const roster_t *roster, int k) {
+    return roster -> course_ids + roster -> first[k];
+}
+
+/*
+ * Remove students from k on, together with their courses and names.
+ * They must lie at the end of both pools, as students just read do.
+ */
+void roster_cut(roster_t *roster, int k) {
+    if (k >= roster -> S) return;
+    roster -> ids_size = roster -> first[k];
+    roster -> text_size = roster -> name[k];
+    roster -> S = k;
+}
+
+/*
+ * Append all students of from (which has no moved students) to roster.
+ */
+void roster_append(roster_t *roster, const roster_t *from) {
+    int ids_size = roster -> ids_size;
+    size_t text_size = roster -> text_size;
+
+    for (int k = 0; k < from -> S; ++k) {
+        roster_begin(roster);
+        roster -> first[roster -> S] = ids_size + from -> first[k];
+        roster -> count[roster -> S] = from -> count[k];
+        roster -> name[roster -> S] = text_size + from -> name[k];
+        roster -> code[roster -> S] = text_size + from -> code[k];
+        roster_end(roster);
+    }
+
+    for (int j = 0; j < from -> ids_size; ++j) {
+        roster_push_id(roster, from -> course_ids[j]);
+    }
+    if (from -> text_size > 0) roster_put_text(roster, from -> text, from -> text_size - 1, '\0'); // pool ends by zero of the last code
+}
+
+/*
+ * Enroll student k into course, moving their courses to the end of course_ids if they are not there.
  */
-student_t *create_student(int id, char *name, char *code, int *courses) {
-    student_t *stud = malloc(sizeof(student_t));
+void roster_enroll(roster_t *roster, int k, int course) {
+    if (roster -> first[k] + roster -> count[k] != roster -> ids_size) {
+        int first = roster -> ids_size;
+        for (int j = 0; j < roster -> count[k]; ++j) {
+            roster_push_id(roster, roster -> course_ids[roster -> first[k] + j]);
+        }
+        roster -> first[k] = first;
+    }
 
-    stud -> id = id;
-    stud -> name = name;
-    stud -> code = code;
-    stud -> courses = courses;
+    roster_push_id(roster, course);
+    roster -> count[k]++;
+}
 
-    return stud;
+/*
+ * Remove course from courses of student k. If they do not have it: 1; otherwise: 0
+ */
+int roster_drop(roster_t *roster, int k, int course) {
+    int *courses = roster_courses(roster, k);
+    int j = 0;
+    for (; j < roster -> count[k] && courses[j] != course; ++j);
+
+    if (j == roster -> count[k]) return 1;
+    memmove(courses + j, courses + j + 1, (roster -> count[k] - j - 1) * sizeof(int));
+    roster -> count[k]--;
+    return 0;
 }
 
 /*
  * Creates new hash table of size TABLE_SIZE with NULL courses.
  */
 chash_t *create_courses_hashtable() {
-    chash_t *courses_hashtable = malloc(sizeof(courses_hashtable));
+    chash_t *courses_hashtable = malloc(sizeof(chash_t));
     courses_hashtable -> courses = malloc(TABLE_SIZE * sizeof(course_t*));
+    courses_hashtable -> frozen = NULL;
 
     for (int i = 0; i < TABLE_SIZE; ++i) {
         (courses_hashtable -> courses)[i] = NULL;
@@ -320,10 +801,35 @@ course_t *getCourseFromHashTable(chash_t *c_hash, char const *name) {
     return !found ? c_hash -> courses[i] : NULL;
 }
 
+/*
+ * Build perfect hash of all C courses. No course can be added after it.
+ * Course ids are their indexes in courses.
+ */
+void freezeCoursesHashTable(chash_t *c_hash, int C, course_t **courses) {
+    char **names = malloc((C + 1) * sizeof(char *));
+    for (int i = 0; i < C; ++i) {
+        names[i] = courses[i] -> name;
+    }
+
+    c_hash -> frozen = freeze_names(C, names);
+    free(names);
+}
+
+/*
+ * Remove all courses from hashtable so it can be filled again.
+ */
+void clearCoursesHashTable(chash_t *c_hash) {
+    memset(c_hash -> courses, 0, TABLE_SIZE * sizeof(course_t *));
+    if (c_hash -> frozen != NULL) free_frozen_names(c_hash -> frozen);
+    c_hash -> frozen = NULL;
+}
+
 /*
  * Get id of course by the given name.
  */
 int getCourseIdFromHashTable(chash_t *c_hash, char const *name) {
+    if (c_hash -> frozen != NULL) return frozen_find(c_hash -> frozen, name);
+
     course_t *course = getCourseFromHashTable(c_hash, name);
 
     if (course == NULL) return -1;
@@ -381,6 +887,13 @@ professor_t *getProfFromHashTable(phash_t *p_hash, char const *name) {
     return !found ? p_hash -> professors[i] : NULL;
 }
 
+/*
+ * Remove all professors from hashtable so it can be filled again.
+ */
+void clearProfsHashTable(phash_t *p_hash) {
+    memset(p_hash -> professors, 0, TABLE_SIZE * sizeof(professor_t *));
+}
+
 /*
  * Creates new hash table of size TABLE_SIZE with NULL professors.
  */
@@ -432,6 +945,13 @@ ta_t *getTaFromHashTable(thash_t *t_hash, char const *name) {
     return !found ? t_hash -> tas[i] : NULL;
 }
 
+/*
+ * Remove all TAs from hashtable so it can be filled again.
+ */
+void clearTasHashTable(thash_t *t_hash) {
+    memset(t_hash -> tas, 0, TABLE_SIZE * sizeof(ta_t *));
+}
+
 /*
  * Create pool of tas.
  * tas_pool[i] = array of tas id, who can be assigned to course i.
@@ -445,24 +965,49 @@ int **create_tas_pool(int C, int T, ta_t **tas) {
 
     for (int i = 0; i < T; ++i) {
         for (int j = 1; j < tas[i] -> courses[0] + 1; ++j) {
-            ta_pool[tas[i] -> courses[j]][++ta_pool[tas[i] -> courses[j]][0]] = i;
+            int *pool = ta_pool[tas[i] -> courses[j]];
+            if (pool[0] > 0 && pool[pool[0]] == i) continue; // the same course is listed twice
+            pool[++pool[0]] = i;
         }
     }
 
     return ta_pool;
 }
 
+/*
+ * Create pool of professors.
+ * profs_pool[i] = array of professors id, who are trained for course i.
+ */
+int **create_profs_pool(int C, int P, professor_t **profs) {
+    int **profs_pool = malloc(C * sizeof(int *));
+    for (int i = 0; i < C; ++i) {
+        profs_pool[i] = malloc((P + 1) * sizeof(int)); // first element is for size
+        profs_pool[i][0] = 0;
+    }
+
+    for (int i = 0; i < P; ++i) {
+        for (int j = 1; j < profs[i] -> courses[0] + 1; ++j) {
+            int *pool = profs_pool[profs[i] -> courses[j]];
+            if (pool[0] > 0 && pool[pool[0]] == i) continue; // the same course is listed twice
+            pool[++pool[0]] = i;
+        }
+    }
+
+    return profs_pool;
+}
+
 /*
  * Create c_studs.
  * c_studs[i] = the number of students who want to enroll in course i.
  */
-int *create_c_studs(int C, int S, student_t **studs) {
+int *create_c_studs(int C, const roster_t *roster) {
     int *c_studs = malloc(C * sizeof(int)); // free this
     memset(c_studs, 0, C * sizeof(int));
 
-    for (int i = 0; i < S; ++i) {
-        for (int j = 1; j < studs[i] -> courses[0] + 1; ++j) {
-            c_studs[studs[i] -> courses[j]] += 1;
+    for (int k = 0; k < roster -> S; ++k) {
+        const int *courses = roster_courses(roster, k);
+        for (int j = 0; j < roster -> count[k]; ++j) {
+            c_studs[courses[j]] += 1;
         }
     }
 
@@ -470,11 +1015,35 @@ int *create_c_studs(int C, int S, student_t **studs) {
 }
 
 
+/*
+ * Random number generator with state that can be saved and restored (splitmix64).
+ */
+typedef struct rng_s {
+    unsigned long long state;
+} rng_t;
+
+__thread rng_t rng; // every thread has own generator
+
+/*
+ * Start sequence of generator from seed.
+ */
+void rng_seed(rng_t *r, unsigned long long seed) {
+    r -> state = seed;
+}
+
+/*
+ * Next random 64-bit number.
+ */
+unsigned long long rng_next(rng_t *r) {
+    r -> state += 0x9e3779b97f4a7c15ULL;
+    return mix64(r -> state);
+}
+
 /*
  * Generate random int between start and end
  */
 int randInt(int start, int end) {
-    return (rand() % (end - start)) + start;
+    return (int) (rng_next(&rng) % (unsigned) (end - start)) + start;
 }
 
 /*
@@ -504,6 +1073,16 @@ typedef struct p_ind {
     course_t *course2;
 } p_ind_t;
 
+/*
+ * Is a in arr. arr[0] = size of arr;
+ */
+int is_in_courses(int a, const int *arr) {
+    for (int i = 1; i < arr[0] + 1; ++i) {
+        if (arr[i] == a) return 1;
+    }
+    return 0;
+}
+
 /*
  * Check if the professor has the given course (yes - 1; no - 0).
  */
@@ -518,104 +1097,298 @@ int prof_has_course(professor_t *prof, course_t *course) {
 }
 
 /*
- * Create course inside individual.
+ * Counters that show how much of the sampling effort is wasted.
  */
-cind_t *create_cind(course_t *course) {
-    cind_t *cind = malloc(sizeof(cind_t));
+typedef struct solver_stats_s {
+    long long individuals; // individuals created
+    long long wasted; // individuals scored with MAX_BADNESS_POINTS
+    long long infeasible; // individuals that broke constraints and were repaired
+    long long skipped_courses; // courses not run because their TAs were busy with other courses
+    long long dropped_courses; // courses removed by repair
+    long long refilled_courses; // courses made runnable by repair
+    long long distinct; // individuals with different assignments in population zero
+    long long cache_lookups; // lookups in fitness cache
+    long long cache_hits; // individuals whose badness was taken from fitness cache
+    long long generations; // generations done after population zero
+    long long genome_bytes; // bytes of one compact genome
+    long long population_bytes; // bytes of compact population with badness and hashes
+    long long checkpoints; // checkpoints written
+    long long resumed; // 1 if search was continued from checkpoint
+    long long improvements; // improvements of the best individual written into stream
+    long long components; // groups of courses solved separately
+    long long badness; // badness points of the best individual
+    long long lower_bound; // lower bound of badness points, see lower_bound
+    long long bound_reached; // searches stopped because their best individual reached the lower bound
+    long long allocations; // blocks allocated by track_malloc and friends
+    long long generation_allocations; // of them, allocated during generations after population zero
+    long long recycled; // individuals reused by reuse_ind instead of allocated
+    long long live_bytes; // bytes allocated by track_malloc and not freed yet
+    long long peak_bytes; // maximum of live_bytes
+    long long steady_steps; // children made by steady-state search
+    long long replaced; // members of steady-state population replaced by children
+    long long diversity; // different genes of parents in the last generation, per mille (see population_diversity)
+    long long lowest_diversity; // the lowest diversity of all generations, per mille
+    long long mutation_size; // mutants in the last generation
+    long long best_size; // parents in the last generation
+    long long greedy; // genomes of population zero built by greedy_genome
+    long long perf[PHASES][PERF_COUNTERS]; // hardware counters of phases, see perf_phase
+    long long perf_missing; // threads that could not open hardware counters
+    long long lanes; // lanes of portfolio solver
+    long long winner; // lane of portfolio solver that found the best solution
+    long long winner_strategy; // its strategy, see STRATEGY_GENERATIONS
+    long long shared; // genomes taken by lanes of portfolio from the best solution of other lanes
+} stats_t;
+
+__thread stats_t stats; // counters of solve running in this thread
 
-    cind -> runnable = 0;
-    cind -> course = course;
-    cind -> prof = NULL;
-    cind -> ta_number = 0;
-    cind -> tas = NULL;
+/*
+ * Hardware counters of one thread, read as one group.
+ */
+typedef struct perf_s {
+    int enabled; // 1 - phases are counted (--profile)
+    int state; // 0 - counters are not open, 1 - open, -1 - they cannot be opened
+    int phase; // phase counted now, -1 - none
+    int fd[PERF_COUNTERS]; // fd[0] leads the group
+    unsigned long long last[PERF_COUNTERS]; // values when the current phase started
+} perf_t;
 
-    return cind;
-}
+__thread perf_t perf = {.phase = -1};
 
 /*
- * Add TA to course inside individual.
+ * Open group of counters of calling thread, only user space is counted.
  */
-void add_ta_to_cind(cind_t *cind, ta_t *ta, int num) {
-    cind -> tas[cind -> ta_number] = malloc(sizeof(ta_c_t)); // free here
-    cind -> tas[cind -> ta_number] -> number = num;
-    cind -> tas[cind -> ta_number] -> ta = ta;
-    cind -> ta_number++;
+void perf_open() {
+#ifdef __linux__
+    static const unsigned long long events[PERF_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (int k = 0; k < PERF_COUNTERS; ++k) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = events[k];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = k == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        perf.fd[k] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, k == 0 ? -1 : perf.fd[0], 0);
+        if (perf.fd[k] == -1) {
+            while (k-- > 0) close(perf.fd[k]);
+            perf.state = -1;
+            stats.perf_missing++;
+            return;
+        }
+    }
+
+    ioctl(perf.fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    perf.state = 1;
+#else
+    perf.state = -1;
+    stats.perf_missing++;
+#endif
 }
 
 /*
- * Randomly distribute professors in a given individual.
+ * Close counters of calling thread; they are opened again by the next perf_phase.
  */
-void distr_profs(int P, professor_t **profs, int C, course_t **courses, ind_t *ind) {
-    int *shuffled = create_shuffle(0, C);
-
-    int cur_course = 0;
-
-    for (int i = 0; i < P; ++i) {
-        if (cur_course < C) {
-            ind -> cinds[shuffled[cur_course]] -> prof = profs[i];
-            if (cur_course + 1 < C && prof_has_course(profs[i], courses[shuffled[cur_course]]) && prof_has_course(profs[i], courses[shuffled[cur_course + 1]])) {
-                ind -> cinds[shuffled[cur_course + 1]] -> prof = profs[i];
-                ++cur_course;
-            }
-
-            ++cur_course;
+void perf_close() {
+    if (perf.state == 1) {
+        for (int k = 0; k < PERF_COUNTERS; ++k) {
+            close(perf.fd[k]);
         }
     }
-    free(shuffled);
+    perf.state = 0;
+    perf.phase = -1;
 }
 
 /*
- * Randomly distribute TAs in a given individual.
+ * Add counters since the last call to the current phase in stats and start counting phase (-1 - stop).
+ * Does nothing without --profile. Returns the phase counted before, so nested phases can restore it.
  */
-void distr_tas(int C, int T, course_t **courses, ta_t **tas, int **tas_pool, ind_t *ind) {
-    int *avail_tas = malloc(T * sizeof(int)); // array of availability status
-    for (int i = 0; i < T; ++i) {
-        avail_tas[i] = 4;
-    }
+int perf_phase(int phase) {
+    int outer = perf.phase;
+    if (!perf.enabled) return outer;
+    if (perf.state == 0) perf_open();
 
-    for (int i = 0; i < C; ++i) {
-        int *shuffled = create_shuffle(1, tas_pool[i][0] + 1);
-        int tas_needed = courses[i] -> labs_number;
-        int wentAll = tas_pool[i][0] == 0;
-        int curTA = 0;
+    perf.phase = phase;
+    if (perf.state != 1) return outer;
 
-        if (ind -> cinds[i] -> prof == NULL) continue;
+    unsigned long long values[PERF_COUNTERS + 1]; // number of counters, then their values
+    if (read(perf.fd[0], values, sizeof(values)) != sizeof(values)) return outer;
 
-        ind -> cinds[i] -> tas = malloc((MAX_COURSES + 1) * sizeof(ta_c_t*)); // free here
-        while (tas_needed > 0 && !wentAll) {
-            if (avail_tas[tas_pool[i][shuffled[curTA]]] != 0 && tas_needed <= avail_tas[tas_pool[i][shuffled[curTA]]]) {
-                add_ta_to_cind(ind -> cinds[i], tas[tas_pool[i][shuffled[curTA]]], tas_needed);
+    for (int k = 0; k < PERF_COUNTERS; ++k) {
+        if (outer != -1) stats.perf[outer][k] += (long long) (values[k + 1] - perf.last[k]);
+        perf.last[k] = values[k + 1];
+    }
 
-                avail_tas[tas_pool[i][shuffled[curTA]]] -= tas_needed;
-                tas_needed = 0;
-            } else if (avail_tas[tas_pool[i][shuffled[curTA]]] != 0) {
-                add_ta_to_cind(ind -> cinds[i], tas[tas_pool[i][shuffled[curTA]]], avail_tas[tas_pool[i][shuffled[curTA]]]);
+    return outer;
+}
 
-                tas_needed -= avail_tas[tas_pool[i][shuffled[curTA]]];
-                avail_tas[tas_pool[i][shuffled[curTA]]] = 0;
-            }
+/*
+ * Count block allocated by track_* functions in stats of this thread.
+ */
+void track_allocated(void *ptr) {
+    if (ptr == NULL) return;
 
-            ++curTA;
-            wentAll = tas_pool[i][0] == curTA;
-        }
+    stats.allocations++;
+    stats.live_bytes += (long long) malloc_usable_size(ptr);
+    stats.peak_bytes = stats.live_bytes > stats.peak_bytes ? stats.live_bytes : stats.peak_bytes;
+}
 
-        if (tas_needed > 0) {
-            for (int j = 0; j < ind -> cinds[i] -> ta_number; ++j) {
-                avail_tas[ind -> cinds[i] -> tas[j] -> ta -> id] = ind -> cinds[i] -> tas[j] -> number; // sos
-                free(ind -> cinds[i] -> tas[j]);
-            }
+/*
+ * malloc that is counted in stats. Memory of the search is allocated by track_* functions,
+ * so heap traffic of every generation can be seen with --stats.
+ */
+void *track_malloc(size_t size) {
+    void *ptr = malloc(size);
+    track_allocated(ptr);
+    return ptr;
+}
 
-            free(ind -> cinds[i] -> tas);
+/*
+ * calloc that is counted in stats.
+ */
+void *track_calloc(size_t n, size_t size) {
+    void *ptr = calloc(n, size);
+    track_allocated(ptr);
+    return ptr;
+}
 
-            ind -> cinds[i] -> ta_number = 0;
-            ind -> cinds[i] -> tas = NULL;
-            ind -> cinds[i] -> prof = NULL;
-            ind -> cinds[i] -> runnable = 0;
-        } else {
-            ind -> cinds[i] -> runnable = 1;
-        }
+/*
+ * realloc that is counted in stats.
+ */
+void *track_realloc(void *ptr, size_t size) {
+    if (ptr != NULL) stats.live_bytes -= (long long) malloc_usable_size(ptr);
+    ptr = realloc(ptr, size);
+    track_allocated(ptr);
+    return ptr;
+}
+
+/*
+ * Free block allocated by track_* functions.
+ */
+void track_free(void *ptr) {
+    if (ptr == NULL) return;
+
+    stats.live_bytes -= (long long) malloc_usable_size(ptr);
+    free(ptr);
+}
+
+/*
+ * Create course inside individual.
+ */
+cind_t *create_cind(course_t *course) {
+    cind_t *cind = track_malloc(sizeof(cind_t));
+
+    cind -> runnable = 0;
+    cind -> course = course;
+    cind -> prof = NULL;
+    cind -> ta_number = 0;
+    cind -> ta_capacity = 0;
+    cind -> tas = NULL;
+
+    return cind;
+}
+
+/*
+ * Add TA to course inside individual. TA entry left by previous use of individual is reused.
+ */
+void add_ta_to_cind(cind_t *cind, ta_t *ta, int num) {
+    if (cind -> ta_number == cind -> ta_capacity) cind -> tas[cind -> ta_capacity++] = track_malloc(sizeof(ta_c_t)); // free here
+    cind -> tas[cind -> ta_number] -> number = num;
+    cind -> tas[cind -> ta_number] -> ta = ta;
+    cind -> ta_number++;
+}
+
+/*
+ * Choose random prof that can teach course i.
+ * Trained profs with free slot are preferred; otherwise a free prof teaches it as untrained course.
+ * prof_load[p] = number of courses of prof p, 2 means prof cannot take more courses.
+ * Returns id of chosen prof or -1.
+ */
+int pick_prof(int i, int P, int **profs_pool, const int *prof_load) {
+    int chosen = -1, candidates = 0;
+
+    for (int k = 1; k < profs_pool[i][0] + 1; ++k) {
+        if (prof_load[profs_pool[i][k]] < 2 && randInt(0, ++candidates) == 0) chosen = profs_pool[i][k];
+    }
+    if (chosen != -1) return chosen;
+
+    for (int p = 0; p < P; ++p) {
+        if (prof_load[p] == 0 && randInt(0, ++candidates) == 0) chosen = p;
+    }
+
+    return chosen;
+}
+
+/*
+ * Free capacity of TAs from the pool of course i.
+ */
+int pool_capacity(int i, int **tas_pool, const int *avail_tas) {
+    int capacity = 0;
+    for (int k = 1; k < tas_pool[i][0] + 1; ++k) {
+        capacity += avail_tas[tas_pool[i][k]];
+    }
+    return capacity;
+}
+
+/*
+ * Name of strategy of portfolio solver.
+ */
+const char *strategy_name(int strategy) {
+    static const char *names[PORTFOLIO_STRATEGIES] = {"generations", "steady-state", "local search", "components"};
+    return names[strategy];
+}
+
+/*
+ * Print counters into file.
+ */
+void print_stats(FILE *file) {
+    fprintf(file, "individuals: %lld, wasted: %lld (%.2f%%), repaired: %lld (%.2f%%), skipped courses: %lld, dropped courses: %lld, refilled courses: %lld\n",
+            stats.individuals,
+            stats.wasted, stats.individuals ? 100.0 * stats.wasted / stats.individuals : 0.0,
+            stats.infeasible, stats.individuals ? 100.0 * stats.infeasible / stats.individuals : 0.0,
+            stats.skipped_courses, stats.dropped_courses, stats.refilled_courses);
+    fprintf(file, "generations: %lld, distinct in population zero: %lld, greedy: %lld, cache hits: %lld/%lld (%.2f%%)\n",
+            stats.generations, stats.distinct, stats.greedy,
+            stats.cache_hits, stats.cache_lookups, stats.cache_lookups ? 100.0 * stats.cache_hits / stats.cache_lookups : 0.0);
+    fprintf(file, "genome: %lld bytes, population: %lld bytes, checkpoints: %lld%s\n", stats.genome_bytes, stats.population_bytes,
+            stats.checkpoints, stats.resumed ? ", resumed" : "");
+    if (stats.improvements) fprintf(file, "improvements of the best individual: %lld\n", stats.improvements);
+    if (stats.components) fprintf(file, "components solved separately: %lld\n", stats.components);
+    fprintf(file, "allocations: %lld, in generations: %lld (%.2f per generation), recycled individuals: %lld, live: %lld bytes, peak: %lld bytes\n",
+            stats.allocations, stats.generation_allocations, stats.generations ? (double) stats.generation_allocations / stats.generations : 0.0,
+            stats.recycled, stats.live_bytes, stats.peak_bytes);
+    if (stats.generations) fprintf(file, "diversity of parents: %.3f, lowest: %.3f, mutants: %lld, parents: %lld\n",
+                                   stats.diversity / 1000.0, stats.lowest_diversity / 1000.0, stats.mutation_size, stats.best_size);
+    if (stats.lanes) fprintf(file, "portfolio lanes: %lld, winner: lane %lld (%s), genomes shared: %lld\n", stats.lanes, stats.winner,
+                             strategy_name((int) stats.winner_strategy), stats.shared);
+    if (stats.steady_steps) fprintf(file, "steady-state steps: %lld, members replaced: %lld (%.2f%%)\n", stats.steady_steps, stats.replaced,
+                                    100.0 * stats.replaced / stats.steady_steps);
+    fprintf(file, "badness: %lld, lower bound: %lld, gap: %lld (%.2f%%), searches stopped at bound: %lld\n",
+            stats.badness, stats.lower_bound, stats.badness - stats.lower_bound,
+            stats.badness ? 100.0 * (stats.badness - stats.lower_bound) / stats.badness : 0.0, stats.bound_reached);
+}
+
+/*
+ * Print hardware counters of phases of input name into file.
+ */
+void print_profile(FILE *file, const char *name) {
+    static const char *phases[PHASES] = {"parse", "pools", "generation", "selection", "search", "output"};
 
-        free(shuffled);
+    if (stats.perf_missing) {
+        fprintf(file, "%s: hardware counters are not available\n", name);
+        return;
+    }
+
+    fprintf(file, "%s:\n%-12s %14s %14s %6s %12s %12s\n", name, "phase", "cycles", "instructions", "IPC", "cache misses", "branch misses");
+    for (int phase = 0; phase < PHASES; ++phase) {
+        long long *counters = stats.perf[phase];
+        fprintf(file, "%-12s %14lld %14lld %6.2f %12lld %12lld\n", phases[phase], counters[0], counters[1],
+                counters[0] ? (double) counters[1] / counters[0] : 0.0, counters[2], counters[3]);
     }
 }
 
@@ -624,21 +1397,23 @@ void distr_tas(int C, int T, course_t **courses, ta_t **tas, int **tas_pool, ind
  */
 void free_ind(int C, ind_t *ind) {
     for (int i = 0; i < C; ++i) {
-        for (int j = 0; j < ind -> cinds[i] -> ta_number; ++j) {
-            free(ind -> cinds[i] -> tas[j]);
+        for (int j = 0; j < ind -> cinds[i] -> ta_capacity; ++j) {
+            track_free(ind -> cinds[i] -> tas[j]);
         }
 
-        free(ind -> cinds[i]);
+        track_free(ind -> cinds[i] -> tas);
+        track_free(ind -> cinds[i]);
     }
 
-    free(ind);
+    track_free(ind -> cinds);
+    track_free(ind);
 }
 
 /*
  * Calculate badness points for a given individual.
  * Give MAX_BADNESS_POINTS to individuals that cannot exist.
  */
-int calculate_badness(int C, int P, int T, course_t **courses, ind_t *ind, int *c_studs) {
+int calculate_badness(int C, int P, int T, ind_t *ind, int *c_studs) {
     int badness_points = 0;
     int *profs_badness = malloc(P * sizeof(int));
     int *tas_badness = malloc(T * sizeof(int));
@@ -660,17 +1435,18 @@ int calculate_badness(int C, int P, int T, course_t **courses, ind_t *ind, int *
         }
     }
 
+    int impossible = 0;
     for (int i = 0; i < P; ++i) {
         if (2 - profs_badness[i] < 0) {
-            ind -> badness_points = MAX_BADNESS_POINTS;
+            impossible = 1;
             break;
         }
         badness_points += 5 * (2 - profs_badness[i]);
     }
 
     for (int i = 0; i < T; ++i) {
-        if ((ind -> badness_points == MAX_BADNESS_POINTS) || 4 - tas_badness[i] < 0) {
-            ind -> badness_points = MAX_BADNESS_POINTS;
+        if (impossible || 4 - tas_badness[i] < 0) {
+            impossible = 1;
             break;
         }
         badness_points += 2 * (4 - tas_badness[i]);
@@ -679,567 +1455,4230 @@ int calculate_badness(int C, int P, int T, course_t **courses, ind_t *ind, int *
     free(profs_badness);
     free(tas_badness);
 
+    if (impossible) badness_points = MAX_BADNESS_POINTS;
+
     ind -> badness_points = badness_points;
     return badness_points;
 }
 
 /*
- * Choose BEST_SIZE best individuals in population inds.
+ * Population stored as structure of arrays, used for scoring many individuals at once.
+ * Every array is gene-major: the value for gene g of individual j is stored at [g * n + j],
+ * so the same gene of consecutive individuals forms one contiguous vector.
  */
-void choose_best_inds(int C, ind_t **inds) {
-    int *was = malloc(POPULATION_SIZE * sizeof(int)); // free here
-    ind_t **best_inds = malloc(BEST_SIZE * sizeof(ind_t *));
-    memset(was, 0, POPULATION_SIZE * sizeof(int));
+typedef struct population_soa_s {
+    int n; // number of lanes (multiple of SOA_LANES)
+    int C;
+    int P;
+    int T;
+    int *runnable; // runnable[i * n + j] - 1 if course i runs in individual j
+    int *prof_load; // prof_load[p * n + j] - number of courses of prof p in individual j
+    int *ta_load; // ta_load[t * n + j] - number of labs of ta t in individual j
+    int *badness; // badness[j] - result of scoring
+} soa_t;
 
-    for (int i = 0; i < BEST_SIZE; ++i) {
-        int cur_best = MAX_BADNESS_POINTS;
-        int cur_best_i = -1;
-        for (int j = 0; j < POPULATION_SIZE; ++j) {
-            if (!was[j] && inds[j] -> badness_points < cur_best) {
-                cur_best = inds[j] -> badness_points;
-                cur_best_i = j;
-            }
+/*
+ * Create empty structure of arrays for at least n individuals.
+ */
+soa_t *create_soa(int n, int C, int P, int T) {
+    soa_t *soa = track_malloc(sizeof(soa_t));
+
+    soa -> n = (n + SOA_LANES - 1) / SOA_LANES * SOA_LANES;
+    soa -> C = C;
+    soa -> P = P;
+    soa -> T = T;
+    soa -> runnable = track_calloc((size_t) C * soa -> n, sizeof(int));
+    soa -> prof_load = track_calloc((size_t) P * soa -> n, sizeof(int));
+    soa -> ta_load = track_calloc((size_t) T * soa -> n, sizeof(int));
+    soa -> badness = track_calloc((size_t) soa -> n, sizeof(int));
+
+    return soa;
+}
+
+/*
+ * Free space that was used by structure of arrays.
+ */
+void free_soa(soa_t *soa) {
+    track_free(soa -> runnable);
+    track_free(soa -> prof_load);
+    track_free(soa -> ta_load);
+    track_free(soa -> badness);
+    track_free(soa);
+}
+
+/*
+ * Reset loads of all lanes before storing new individuals.
+ */
+void soa_clear(soa_t *soa) {
+    memset(soa -> prof_load, 0, (size_t) soa -> P * soa -> n * sizeof(int));
+    memset(soa -> ta_load, 0, (size_t) soa -> T * soa -> n * sizeof(int));
+}
+
+/*
+ * Put individual ind into lane j of the structure of arrays.
+ * The lane must be cleared by soa_clear before.
+ */
+void soa_store_ind(soa_t *soa, int j, ind_t *ind) {
+    int n = soa -> n;
+
+    for (int i = 0; i < soa -> C; ++i) {
+        cind_t *cind = ind -> cinds[i];
+
+        soa -> runnable[i * n + j] = cind -> runnable != 0;
+        if (!cind -> runnable) continue;
+
+        soa -> prof_load[cind -> prof -> id * n + j]++;
+        for (int k = 0; k < cind -> ta_number; ++k) {
+            soa -> ta_load[cind -> tas[k] -> ta -> id * n + j] += cind -> tas[k] -> number;
         }
-        best_inds[i] = inds[cur_best_i];
-        was[cur_best_i] = 1;
     }
+}
+
+/*
+ * Calculate badness points for every lane of the structure of arrays.
+ * Gives the same result as calculate_badness for each individual.
+ * Uses SSE2 when it is available and plain loops otherwise.
+ */
+void calculate_badness_batch(soa_t *soa, course_t **courses, const int *c_studs) {
+    int n = soa -> n;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i four = _mm_set1_epi32(4);
+    const __m128i ten = _mm_set1_epi32(10);
+    const __m128i eight = _mm_set1_epi32(8);
+    const __m128i max_points = _mm_set1_epi32(MAX_BADNESS_POINTS);
+
+    for (int j = 0; j < n; j += SOA_LANES) {
+        __m128i sum = zero;
+        __m128i impossible = zero;
+
+        for (int i = 0; i < soa -> C; ++i) {
+            __m128i unrun_pen = _mm_set1_epi32(20 + c_studs[i]);
+            __m128i over_pen = _mm_set1_epi32(maximum(0, c_studs[i] - courses[i] -> students_number));
+            __m128i not_run = _mm_cmpeq_epi32(_mm_loadu_si128((__m128i *) (soa -> runnable + i * n + j)), zero);
+
+            sum = _mm_add_epi32(sum, _mm_or_si128(_mm_and_si128(not_run, unrun_pen), _mm_andnot_si128(not_run, over_pen)));
+        }
+
+        for (int p = 0; p < soa -> P; ++p) {
+            __m128i load = _mm_loadu_si128((__m128i *) (soa -> prof_load + p * n + j));
+
+            impossible = _mm_or_si128(impossible, _mm_cmpgt_epi32(load, two));
+            // 5 * (2 - load) = 10 - (4 * load + load)
+            sum = _mm_add_epi32(sum, _mm_sub_epi32(ten, _mm_add_epi32(_mm_slli_epi32(load, 2), load)));
+        }
+
+        for (int t = 0; t < soa -> T; ++t) {
+            __m128i load = _mm_loadu_si128((__m128i *) (soa -> ta_load + t * n + j));
+
+            impossible = _mm_or_si128(impossible, _mm_cmpgt_epi32(load, four));
+            // 2 * (4 - load) = 8 - 2 * load
+            sum = _mm_add_epi32(sum, _mm_sub_epi32(eight, _mm_slli_epi32(load, 1)));
+        }
+
+        sum = _mm_or_si128(_mm_and_si128(impossible, max_points), _mm_andnot_si128(impossible, sum));
+        _mm_storeu_si128((__m128i *) (soa -> badness + j), sum);
+    }
+#else
+    int *impossible = calloc((size_t) n, sizeof(int));
+    memset(soa -> badness, 0, (size_t) n * sizeof(int));
 
-    for (int i = 0; i < POPULATION_SIZE; ++i) {
-        if (!was[i]) {
-            free_ind(C, inds[i]);
+    for (int i = 0; i < soa -> C; ++i) {
+        int unrun_pen = 20 + c_studs[i];
+        int over_pen = maximum(0, c_studs[i] - courses[i] -> students_number);
+        const int *runnable = soa -> runnable + i * n;
+
+        for (int j = 0; j < n; ++j) {
+            soa -> badness[j] += runnable[j] ? over_pen : unrun_pen;
+        }
+    }
+
+    for (int p = 0; p < soa -> P; ++p) {
+        const int *load = soa -> prof_load + p * n;
+
+        for (int j = 0; j < n; ++j) {
+            impossible[j] |= load[j] > 2;
+            soa -> badness[j] += 5 * (2 - load[j]);
+        }
+    }
+
+    for (int t = 0; t < soa -> T; ++t) {
+        const int *load = soa -> ta_load + t * n;
+
+        for (int j = 0; j < n; ++j) {
+            impossible[j] |= load[j] > 4;
+            soa -> badness[j] += 2 * (4 - load[j]);
         }
-        inds[i] = i < BEST_SIZE ? best_inds[i] : NULL;
     }
 
-    free(best_inds);
-    free(was);
+    for (int j = 0; j < n; ++j) {
+        if (impossible[j]) soa -> badness[j] = MAX_BADNESS_POINTS;
+    }
+
+    free(impossible);
+#endif
 }
 
 /*
- * Create a random individual.
+ * Canonical hash of prof and TA assignment of individual.
+ * TAs of a course are combined by sum, so their order does not matter.
+ * Never returns 0, it marks empty cache slots.
  */
-ind_t *create_ind(int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **tas_pool, int *c_studs) {
-    ind_t *ind = malloc(sizeof(ind_t)); // free here
-    ind -> cinds = malloc(C * sizeof(cind_t*)); // free here
+unsigned long long ind_hash(int C, ind_t *ind) {
+    unsigned long long h = 0;
 
     for (int i = 0; i < C; ++i) {
-        ind -> cinds[i] = create_cind(courses[i]); // free here
-    }
+        cind_t *cind = ind -> cinds[i];
+        if (!cind -> runnable) continue;
 
-    distr_profs(P, profs, C, courses, ind);
-    distr_tas(C, T, courses, tas, tas_pool, ind);
-
-    calculate_badness(C, P, T, courses, ind, c_studs);
+        unsigned long long course_h = mix64(((unsigned long long) i << 32) | (unsigned) cind -> prof -> id);
+        for (int j = 0; j < cind -> ta_number; ++j) {
+            course_h += mix64(((unsigned long long) (i + 1) << 40) ^ ((unsigned long long) cind -> tas[j] -> ta -> id << 8) ^ (unsigned) cind -> tas[j] -> number);
+        }
+        h += mix64(course_h);
+    }
 
-    return ind;
+    return h ? h : 1;
 }
 
 /*
- * Struct that is used for returning information about token in nextToken function.
+ * Bounded cache from hash of individual to its badness points.
+ * Open addressing with at most CACHE_PROBES probes; when all of them are taken,
+ * the entry at the home slot is overwritten.
  */
-struct flag_s {
-    short contains_digits: 1;
-    short contains_letters: 1;
-    short last_token: 1;
-    short contains_invalid_symbs: 1;
-    int length;
-};
+typedef struct fitness_cache_s {
+    unsigned long long *keys; // 0 - empty slot
+    int *badness;
+    long long lookups;
+    long long hits;
+} fcache_t;
 
 /*
- * Set flag's fields to default values.
+ * Create empty cache of CACHE_SIZE entries.
  */
-void clearFlag(struct flag_s *flag) {
-    flag -> contains_digits = 0;
-    flag -> contains_letters = 0;
-    flag -> last_token = 0;
-    flag -> contains_invalid_symbs = 0;
-    flag -> length = 0;
+fcache_t *create_fcache() {
+    fcache_t *cache = track_malloc(sizeof(fcache_t));
+
+    cache -> keys = track_calloc(CACHE_SIZE, sizeof(unsigned long long));
+    cache -> badness = track_malloc(CACHE_SIZE * sizeof(int));
+    cache -> lookups = 0;
+    cache -> hits = 0;
+
+    return cache;
 }
 
 /*
- * Put a part of given line until a space to buffer.
- * Also put flags to flag structure.
+ * Free space that was used by cache.
  */
-char *nextToken(char* buf, size_t size, char *line, struct flag_s *flag) {
-    int i = 0;
-    for (i = 0; i < size - 1 && line[i] != '\0' && line[i] != ' ' && line[i] != '\n'; ++i) {
-        buf[i] = line[i];
-        flag -> contains_digits = flag -> contains_digits || isDigit(line[i]);
-        flag -> contains_letters = flag -> contains_letters || isLetter(line[i]);
-        flag -> contains_invalid_symbs = flag -> contains_invalid_symbs || !isValid(line[i]);
-    }
-
-    buf[i] = '\0';
-    flag -> length = i;
-    flag -> last_token = line[i] == '\0' || line[i] == '\n';
-    if ((buf[0] == 'P' || buf[0] == 'T' || buf[0] == 'S') && buf[1] == '\0') flag -> contains_invalid_symbs = 1;
-    return line + i + 1;
+void free_fcache(fcache_t *cache) {
+    track_free(cache -> keys);
+    track_free(cache -> badness);
+    track_free(cache);
 }
 
 /*
- * Convert string to integer.
- * If any error -> return -1.
+ * Get badness points of individual with the given hash from cache.
+ * If there is no such individual -> return -1.
  */
-int strtint(const char str[]) {
-    int i = 0;
-    int num = 0;
-    while (str[i]) {
-        if (i == 1 && num == 0)
-            return -1;
-        num = num * 10 + str[i] - '0';
-        i++;
+int fcache_get(fcache_t *cache, unsigned long long hash) {
+    cache -> lookups++;
+
+    for (int k = 0; k < CACHE_PROBES; ++k) {
+        int i = (int) ((hash + k) & (CACHE_SIZE - 1));
+        if (cache -> keys[i] == 0) return -1;
+        if (cache -> keys[i] == hash) {
+            cache -> hits++;
+            return cache -> badness[i];
+        }
     }
 
-    return i != 0 && num != 0 ? num : -1;
+    return -1;
 }
 
 /*
- * Get course from string.
+ * Put badness points of individual with the given hash into cache.
  */
-course_t *get_c_line(int id, char *line, chash_t *chash) {
-    char *name = malloc(BUFFER_SIZE);
-    int labs_number = 0, students_number = 0;
-    int error = 0, last_token = 0;
-    char *buffer = malloc(BUFFER_SIZE);
-    struct flag_s *flag = malloc(sizeof(struct flag_s));
-    clearFlag(flag);
-    int state = NAME;
+void fcache_put(fcache_t *cache, unsigned long long hash, int badness) {
+    int slot = (int) (hash & (CACHE_SIZE - 1));
 
-    while (!last_token) {
-        line = nextToken(buffer, BUFFER_SIZE, line, flag);
-        if (state == NAME) {
-            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
-                error = 1;
-                break;
-            }
-            strcpy(name, buffer);
-        } else if (state == LABS) {
-            if (flag -> contains_letters || flag -> contains_invalid_symbs || (labs_number = strtint(buffer)) == -1) {
-                error = 1;
-                break;
-            }
-        } else if (state == STUDENTS) {
-            if (flag -> contains_letters || flag -> contains_invalid_symbs || (students_number = strtint(buffer)) == -1) {
-                error = 1;
-                break;
-            }
-        } else if (state == END) {
-            error = 1;
+    for (int k = 0; k < CACHE_PROBES; ++k) {
+        int i = (int) ((hash + k) & (CACHE_SIZE - 1));
+        if (cache -> keys[i] == 0 || cache -> keys[i] == hash) {
+            slot = i;
             break;
         }
-        last_token = flag -> last_token;
-        clearFlag(flag);
-        state++;
     }
 
-    course_t *course = create_course(id, name, labs_number, students_number);
-    if (addCourseToHashTable(chash, course)) error = 1;
+    cache -> keys[slot] = hash;
+    cache -> badness[slot] = badness;
+}
 
-    free(buffer);
-    free(flag);
+/*
+ * Calculate penalty points of individual split into components (OBJ_*).
+ * Their sum is equal to result of calculate_badness for possible individuals.
+ * load is scratch of at least P + T numbers.
+ * Returns 0 for individuals that cannot exist.
+ */
+int calculate_objectives(int C, int P, int T, ind_t *ind, const int *c_studs, int *obj, int *load) {
+    int possible = 1;
+    int *profs_load = load;
+    int *tas_load = load + P;
 
-    if (state != END || error) {
-        free(name);
-        free(course);
-        return NULL;
+    memset(load, 0, (size_t) (P + T) * sizeof(int));
+    memset(obj, 0, OBJECTIVES * sizeof(int));
+
+    for (int i = 0; i < C; ++i) {
+        cind_t *cind = ind -> cinds[i];
+        if (!cind -> runnable) {
+            obj[OBJ_COURSES] += 20 + c_studs[i];
+            continue;
+        }
+
+        profs_load[cind -> prof -> id]++;
+        obj[OBJ_STUDENTS] += maximum(0, c_studs[i] - cind -> course -> students_number);
+        for (int j = 0; j < cind -> ta_number; ++j) {
+            tas_load[cind -> tas[j] -> ta -> id] += cind -> tas[j] -> number;
+        }
     }
 
-    return course;
+    for (int i = 0; i < P; ++i) {
+        possible = possible && profs_load[i] <= 2;
+        obj[OBJ_PROFS] += 5 * (2 - profs_load[i]);
+    }
+    for (int i = 0; i < T; ++i) {
+        possible = possible && tas_load[i] <= 4;
+        obj[OBJ_TAS] += 2 * (4 - tas_load[i]);
+    }
+
+    return possible;
 }
 
 /*
- * Get professor from string.
+ * Write assignment of individual in compact form into a new string:
+ * one token per course separated by spaces, "-" if course is not run,
+ * otherwise "prof/ta:labs,ta:labs" with ids of prof and TAs.
  */
-professor_t *get_p_line(int id, char *line, chash_t *chash, phash_t *phash) {
-    int statesShifts[] = {P_SURNAME, P_COURSES, P_COURSES};
-
-    char *name = malloc(BUFFER_SIZE);
-    char *surname = name;
-    int *courses = malloc(sizeof(int) * (MAX_COURSES + 1));
-    courses[0] = 0; // 0-th <- number of courses
+char *encode_assignment(int C, ind_t *ind) {
+    size_t size = 1;
+    for (int i = 0; i < C; ++i) {
+        size += 24 + 24 * (size_t) ind -> cinds[i] -> ta_number;
+    }
 
-    int state = P_NAME;
-    char *buffer = malloc(BUFFER_SIZE);
-    int error = 0, last_token = 0;
-    struct flag_s *flag = malloc(sizeof(struct flag_s));
-    clearFlag(flag);
+    char *code = track_malloc(size);
+    size_t len = 0;
+    code[0] = '\0';
 
-    while (!last_token) {
-        line = nextToken(buffer, BUFFER_SIZE, line, flag);
-        if (state == P_NAME) {
-            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
-                error = 1;
-                break;
-            }
-            strcpy(name, buffer);
-            name[flag -> length] = ' ';
-            surname = name + flag -> length + 1;
-        } else if (state == P_SURNAME) {
-            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
-                error = 1;
-                break;
-            }
-            strcpy(surname, buffer);
-        } else if (state == P_COURSES) {
-            int courseId;
-            if (flag -> contains_digits || flag -> contains_invalid_symbs || (courseId = getCourseIdFromHashTable(chash, buffer)) == -1) {
-                error = 1;
-                break;
-            }
+    for (int i = 0; i < C; ++i) {
+        cind_t *cind = ind -> cinds[i];
+        if (i > 0) code[len++] = ' ';
 
-            courses[++courses[0]] = courseId;
+        if (!cind -> runnable) {
+            len += sprintf(code + len, "-");
+            continue;
         }
 
-        last_token = flag -> last_token;
-        clearFlag(flag);
-        state = statesShifts[state];
+        len += sprintf(code + len, "%d/", cind -> prof -> id);
+        for (int j = 0; j < cind -> ta_number; ++j) {
+            len += sprintf(code + len, j ? ",%d:%d" : "%d:%d", cind -> tas[j] -> ta -> id, cind -> tas[j] -> number);
+        }
     }
 
-    free(flag);
-    free(buffer);
+    return code;
+}
+
+/*
+ * Member of Pareto front.
+ */
+typedef struct pareto_entry_s {
+    int obj[OBJECTIVES];
+    int badness;
+    char *assignment; // see encode_assignment
+} pentry_t;
+
+/*
+ * Archive of individuals that are not dominated by any other individual found so far.
+ */
+typedef struct pareto_archive_s {
+    int size;
+    long long rejected; // non-dominated individuals that did not fit into the archive
+    pentry_t *entries;
+    int *load; // scratch of calculate_objectives
+    int load_size;
+} archive_t;
+
+/*
+ * Create empty archive for at most ARCHIVE_SIZE individuals.
+ */
+archive_t *create_archive() {
+    archive_t *archive = track_malloc(sizeof(archive_t));
+
+    archive -> size = 0;
+    archive -> rejected = 0;
+    archive -> entries = track_malloc(ARCHIVE_SIZE * sizeof(pentry_t));
+    archive -> load = NULL;
+    archive -> load_size = 0;
+
+    return archive;
+}
+
+/*
+ * Free space that was used by archive.
+ */
+void free_archive(archive_t *archive) {
+    for (int i = 0; i < archive -> size; ++i) {
+        track_free(archive -> entries[i].assignment);
+    }
+    track_free(archive -> entries);
+    track_free(archive -> load);
+    track_free(archive);
+}
+
+/*
+ * Check whether objectives a dominate objectives b (not worse in all, better in one).
+ */
+int dominates(const int *a, const int *b) {
+    int better = 0;
+    for (int k = 0; k < OBJECTIVES; ++k) {
+        if (a[k] > b[k]) return 0;
+        better = better || a[k] < b[k];
+    }
+    return better;
+}
+
+/*
+ * Offer individual to archive. Dominated members are removed.
+ * Returns 1 if the individual was added.
+ */
+int archive_add(archive_t *archive, int C, int P, int T, ind_t *ind, const int *c_studs) {
+    int obj[OBJECTIVES];
+    if (archive -> load_size < P + T) {
+        archive -> load_size = P + T;
+        archive -> load = track_realloc(archive -> load, (size_t) archive -> load_size * sizeof(int));
+    }
+    if (!calculate_objectives(C, P, T, ind, c_studs, obj, archive -> load)) return 0;
+
+    for (int i = 0; i < archive -> size; ++i) {
+        if (dominates(archive -> entries[i].obj, obj) || !memcmp(archive -> entries[i].obj, obj, sizeof(obj))) return 0;
+    }
+
+    int size = 0;
+    for (int i = 0; i < archive -> size; ++i) {
+        if (dominates(obj, archive -> entries[i].obj)) {
+            track_free(archive -> entries[i].assignment);
+        } else {
+            archive -> entries[size++] = archive -> entries[i];
+        }
+    }
+    archive -> size = size;
+
+    if (archive -> size == ARCHIVE_SIZE) {
+        archive -> rejected++;
+        return 0;
+    }
+
+    pentry_t *entry = &archive -> entries[archive -> size++];
+    memcpy(entry -> obj, obj, sizeof(obj));
+    entry -> badness = obj[OBJ_COURSES] + obj[OBJ_PROFS] + obj[OBJ_TAS] + obj[OBJ_STUDENTS];
+    entry -> assignment = encode_assignment(C, ind);
+
+    return 1;
+}
+
+/*
+ * Compare function for qsort of front by total badness.
+ */
+int compare_entries(const void *a, const void *b) {
+    return ((const pentry_t *) a) -> badness - ((const pentry_t *) b) -> badness;
+}
+
+/*
+ * Print Pareto front to existing output file.
+ * First line: size of front. Then one line per individual:
+ * courses, profs, TAs and students penalties, total badness and assignment (see encode_assignment).
+ */
+void write_front(archive_t *archive, FILE *out) {
+    if (out == NULL) return;
+
+    qsort(archive -> entries, archive -> size, sizeof(pentry_t), compare_entries);
+
+    fprintf(out, "%d\n", archive -> size);
+    for (int i = 0; i < archive -> size; ++i) {
+        pentry_t *entry = &archive -> entries[i];
+        fprintf(out, "%d %d %d %d %d %s\n", entry -> obj[OBJ_COURSES], entry -> obj[OBJ_PROFS], entry -> obj[OBJ_TAS],
+                entry -> obj[OBJ_STUDENTS], entry -> badness, entry -> assignment);
+    }
+}
+
+/*
+ * Layout of compact genome of an instance.
+ * Genome is an array of ids: gene i < C is prof of course i, then course i has one gene per lab
+ * in [lab_offset[i], lab_offset[i + 1]) with id of TA that takes the lab, so labs of a TA
+ * are stored as its id repeated. Ids are uint8_t when all of them fit, otherwise uint16_t.
+ * Missing prof or TA is stored as all ones.
+ */
+typedef struct genome_layout_s {
+    int C;
+    int wide; // 1 - ids are uint16_t, 0 - uint8_t
+    int genes; // C + labs of all courses that can be run
+    int *lab_offset; // C + 1 elements
+    size_t size; // bytes of one genome
+} layout_t;
+
+/*
+ * Create layout of genomes for instance.
+ * Courses with more labs than their TAs can take never run, so they get no lab genes.
+ */
+layout_t *create_layout(int C, int P, int T, course_t **courses, int **tas_pool) {
+    layout_t *layout = malloc(sizeof(layout_t));
+
+    layout -> C = C;
+    layout -> wide = P >= GENE_NONE8 || T >= GENE_NONE8;
+    layout -> lab_offset = malloc((C + 1) * sizeof(int));
+    layout -> lab_offset[0] = C;
+    for (int i = 0; i < C; ++i) {
+        int labs = courses[i] -> labs_number <= 4 * tas_pool[i][0] ? courses[i] -> labs_number : 0;
+        layout -> lab_offset[i + 1] = layout -> lab_offset[i] + labs;
+    }
+    layout -> genes = layout -> lab_offset[C];
+    layout -> size = (size_t) layout -> genes * (layout -> wide ? sizeof(uint16_t) : sizeof(uint8_t));
+
+    return layout;
+}
+
+/*
+ * Free space that was used by layout.
+ */
+void free_layout(layout_t *layout) {
+    free(layout -> lab_offset);
+    free(layout);
+}
+
+/*
+ * Get id stored in gene k of genome, -1 if it is missing.
+ */
+int gene_get(const layout_t *layout, const void *genome, int k) {
+    if (layout -> wide) {
+        uint16_t id = ((const uint16_t *) genome)[k];
+        return id == GENE_NONE16 ? -1 : id;
+    }
+
+    uint8_t id = ((const uint8_t *) genome)[k];
+    return id == GENE_NONE8 ? -1 : id;
+}
+
+/*
+ * Put id (or -1) into gene k of genome.
+ */
+void gene_set(const layout_t *layout, void *genome, int k, int id) {
+    if (layout -> wide)
+        ((uint16_t *) genome)[k] = id == -1 ? GENE_NONE16 : (uint16_t) id;
+    else
+        ((uint8_t *) genome)[k] = id == -1 ? GENE_NONE8 : (uint8_t) id;
+}
+
+/*
+ * Write assignment of individual into genome.
+ */
+void encode_ind(const layout_t *layout, ind_t *ind, void *genome) {
+    for (int i = 0; i < layout -> C; ++i) {
+        cind_t *cind = ind -> cinds[i];
+        int k = layout -> lab_offset[i];
+
+        gene_set(layout, genome, i, cind -> runnable ? cind -> prof -> id : -1);
+        for (int j = 0; cind -> runnable && j < cind -> ta_number; ++j) {
+            for (int l = 0; l < cind -> tas[j] -> number && k < layout -> lab_offset[i + 1]; ++l) {
+                gene_set(layout, genome, k++, cind -> tas[j] -> ta -> id);
+            }
+        }
+        for (; k < layout -> lab_offset[i + 1]; ++k) {
+            gene_set(layout, genome, k, -1);
+        }
+    }
+}
+
+/*
+ * Create individual where no course is run.
+ */
+ind_t *new_ind(int C, course_t **courses) {
+    ind_t *ind = track_malloc(sizeof(ind_t)); // free here
+    ind -> cinds = track_malloc(C * sizeof(cind_t*)); // free here
+
+    for (int i = 0; i < C; ++i) {
+        ind -> cinds[i] = create_cind(courses[i]);
+    }
+
+    ind -> hash = 0;
+    ind -> badness_points = MAX_BADNESS_POINTS;
+    return ind;
+}
+
+/*
+ * Write assignment of genome into existing individual with pointers to courses, profs and TAs.
+ * Arrays of the individual are reused, so decoding into a recycled individual does not allocate memory.
+ * Badness points are not calculated here.
+ */
+void decode_into(const layout_t *layout, const void *genome, course_t **courses, professor_t **profs, ta_t **tas, ind_t *ind) {
+    int C = layout -> C;
+
+    for (int i = 0; i < C; ++i) {
+        cind_t *cind = ind -> cinds[i];
+        int prof = gene_get(layout, genome, i);
+        cind -> course = courses[i];
+        cind -> runnable = 0;
+        cind -> prof = NULL;
+        cind -> ta_number = 0;
+        if (prof == -1) continue;
+
+        cind -> runnable = 1;
+        cind -> prof = profs[prof];
+        if (cind -> tas == NULL) cind -> tas = track_malloc(maximum(1, courses[i] -> labs_number) * sizeof(ta_c_t*)); // free here
+        for (int k = layout -> lab_offset[i]; k < layout -> lab_offset[i + 1]; ++k) {
+            int ta = gene_get(layout, genome, k);
+            if (ta == -1) continue;
+
+            if (cind -> ta_number > 0 && cind -> tas[cind -> ta_number - 1] -> ta == tas[ta])
+                cind -> tas[cind -> ta_number - 1] -> number++;
+            else
+                add_ta_to_cind(cind, tas[ta], 1);
+        }
+    }
+
+    ind -> hash = ind_hash(C, ind);
+    ind -> badness_points = MAX_BADNESS_POINTS;
+}
+
+/*
+ * Create individual with pointers to courses, profs and TAs from genome.
+ * Badness points are not calculated here.
+ */
+ind_t *decode_ind(const layout_t *layout, const void *genome, course_t **courses, professor_t **profs, ta_t **tas) {
+    ind_t *ind = new_ind(layout -> C, courses);
+    decode_into(layout, genome, courses, profs, tas, ind);
+    return ind;
+}
+
+/*
+ * Population of compact genomes stored in one block of memory.
+ */
+typedef struct compact_population_s {
+    int n;
+    const layout_t *layout;
+    unsigned char *genomes; // genome j starts at j * layout -> size
+    int *badness;
+    unsigned long long *hash;
+    // scratch of choose_best_genomes, spare arrays grow to the largest best_size
+    char *chosen;
+    int *order;
+    int spare_size;
+    unsigned char *spare_genomes;
+    int *spare_badness;
+    unsigned long long *spare_hash;
+} cpop_t;
+
+/*
+ * Create population of n genomes, they are filled by cpop_store.
+ */
+cpop_t *create_cpop(const layout_t *layout, int n) {
+    cpop_t *pop = track_malloc(sizeof(cpop_t));
+
+    pop -> n = n;
+    pop -> layout = layout;
+    pop -> genomes = track_malloc((size_t) n * layout -> size + 1);
+    pop -> badness = track_malloc(n * sizeof(int));
+    pop -> hash = track_malloc(n * sizeof(unsigned long long));
+    pop -> chosen = track_malloc(n + 1);
+    pop -> order = track_malloc((n + 1) * sizeof(int));
+    pop -> spare_size = 0;
+    pop -> spare_genomes = NULL;
+    pop -> spare_badness = NULL;
+    pop -> spare_hash = NULL;
+
+    return pop;
+}
+
+/*
+ * Free space that was used by population. Layout is not freed.
+ */
+void free_cpop(cpop_t *pop) {
+    track_free(pop -> genomes);
+    track_free(pop -> badness);
+    track_free(pop -> hash);
+    track_free(pop -> chosen);
+    track_free(pop -> order);
+    track_free(pop -> spare_genomes);
+    track_free(pop -> spare_badness);
+    track_free(pop -> spare_hash);
+    track_free(pop);
+}
+
+/*
+ * Bytes allocated for population.
+ */
+size_t cpop_memory(const cpop_t *pop) {
+    return sizeof(cpop_t) + (size_t) pop -> n * (pop -> layout -> size + sizeof(int) + sizeof(unsigned long long)) + 1;
+}
+
+/*
+ * Get genome j of population.
+ */
+unsigned char *cpop_genome(cpop_t *pop, int j) {
+    return pop -> genomes + (size_t) j * pop -> layout -> size;
+}
+
+/*
+ * Scratch arrays used by operators on genomes, so they do not allocate memory for every genome.
+ */
+typedef struct genome_work_s {
+    int *prof_load; // prof_load[p] = number of courses of prof p, 2 means prof cannot take more courses
+    int *avail_tas; // avail_tas[t] = labs that TA t can still take
+    int *order; // random order of courses
+    int *pool_order; // random order of TAs of one course
+    int *rank; // courses in order of greedy_genome (see rank_courses)
+    int *tie; // tie[k] = first position of rank whose course is as good as course rank[k]
+} work_t;
+
+/*
+ * Create scratch arrays for instance.
+ */
+work_t *create_work(int C, int P, int T, int **tas_pool) {
+    work_t *work = track_malloc(sizeof(work_t));
+    int max_pool = 0;
+
+    for (int i = 0; i < C; ++i) {
+        max_pool = maximum(max_pool, tas_pool[i][0]);
+    }
+
+    work -> prof_load = track_malloc((P + 1) * sizeof(int));
+    work -> avail_tas = track_malloc((T + 1) * sizeof(int));
+    work -> order = track_malloc((C + 1) * sizeof(int));
+    work -> pool_order = track_malloc((max_pool + 1) * sizeof(int));
+    work -> rank = track_malloc((C + 1) * sizeof(int));
+    work -> tie = track_malloc((C + 1) * sizeof(int));
+
+    return work;
+}
+
+/*
+ * Free space that was used by scratch arrays.
+ */
+void free_work(work_t *work) {
+    track_free(work -> prof_load);
+    track_free(work -> avail_tas);
+    track_free(work -> order);
+    track_free(work -> pool_order);
+    track_free(work -> rank);
+    track_free(work -> tie);
+    track_free(work);
+}
+
+/*
+ * Reset loads: no prof has courses, every TA can take 4 labs.
+ */
+void work_clear(work_t *work, int P, int T) {
+    memset(work -> prof_load, 0, P * sizeof(int));
+    for (int t = 0; t < T; ++t) {
+        work -> avail_tas[t] = 4;
+    }
+}
+
+/*
+ * Order courses for greedy_genome in work -> rank: courses whose run saves the most badness points first
+ * (students in demand, see lower_bound), among equal ones those with the least spare capacity of qualified TAs.
+ * Courses that cannot be run at all are left at the end.
+ */
+void rank_courses(work_t *work, int C, course_t **courses, int **tas_pool, const int *c_studs) {
+    int *gain = track_malloc((C + 1) * sizeof(int));
+    int *slack = track_malloc((C + 1) * sizeof(int));
+
+    for (int i = 0; i < C; ++i) {
+        slack[i] = 4 * tas_pool[i][0] - courses[i] -> labs_number;
+        gain[i] = slack[i] < 0 ? -1 : 20 + c_studs[i] - maximum(0, c_studs[i] - courses[i] -> students_number) + 5 + 2 * courses[i] -> labs_number;
+        work -> rank[i] = i;
+    }
+    for (int i = 1; i < C; ++i) {
+        for (int j = i; j > 0; --j) {
+            int a = work -> rank[j - 1], b = work -> rank[j];
+            if (gain[a] > gain[b] || gain[a] == gain[b] && slack[a] <= slack[b]) break;
+            work -> rank[j - 1] = b;
+            work -> rank[j] = a;
+        }
+    }
+    for (int k = 0; k < C; ++k) {
+        int a = work -> rank[k], b = k > 0 ? work -> rank[k - 1] : -1;
+        work -> tie[k] = b != -1 && gain[a] == gain[b] && slack[a] == slack[b] ? work -> tie[k - 1] : k;
+    }
+
+    track_free(gain);
+    track_free(slack);
+}
+
+/*
+ * Buffers of one search kept between generations, so steady state of the search does not allocate memory.
+ * Individuals that are not needed any more are kept in free list and reused by reuse_ind.
+ */
+typedef struct search_scratch_s {
+    int C;
+    work_t *work;
+    soa_t *soa;
+    int *lanes; // lanes[k] = index of genome stored in lane k of soa
+    ind_t **free_inds;
+    int free_size;
+    int free_capacity;
+} scratch_t;
+
+/*
+ * Create buffers of search for instance.
+ */
+scratch_t *create_scratch(int C, int P, int T, int **tas_pool) {
+    scratch_t *scratch = track_malloc(sizeof(scratch_t));
+
+    scratch -> C = C;
+    scratch -> work = create_work(C, P, T, tas_pool);
+    scratch -> soa = create_soa(SOA_BLOCK, C, P, T);
+    scratch -> lanes = track_malloc(SOA_BLOCK * sizeof(int));
+    scratch -> free_inds = NULL;
+    scratch -> free_size = 0;
+    scratch -> free_capacity = 0;
+
+    return scratch;
+}
+
+/*
+ * Free buffers of search and individuals in its free list.
+ */
+void free_scratch(scratch_t *scratch) {
+    for (int k = 0; k < scratch -> free_size; ++k) {
+        free_ind(scratch -> C, scratch -> free_inds[k]);
+    }
+
+    track_free(scratch -> free_inds);
+    track_free(scratch -> lanes);
+    free_soa(scratch -> soa);
+    free_work(scratch -> work);
+    track_free(scratch);
+}
+
+/*
+ * Decode genome into individual from free list, or into new one if the list is empty.
+ * Individual is given back by recycle_ind.
+ */
+ind_t *reuse_ind(scratch_t *scratch, const layout_t *layout, const void *genome, course_t **courses, professor_t **profs, ta_t **tas) {
+    ind_t *ind;
+    if (scratch -> free_size > 0) {
+        ind = scratch -> free_inds[--scratch -> free_size];
+        stats.recycled++;
+    } else {
+        ind = new_ind(layout -> C, courses);
+    }
+
+    decode_into(layout, genome, courses, profs, tas, ind);
+    return ind;
+}
+
+/*
+ * Put individual into free list instead of freeing it.
+ */
+void recycle_ind(scratch_t *scratch, ind_t *ind) {
+    if (scratch -> free_size == scratch -> free_capacity) {
+        scratch -> free_capacity = scratch -> free_capacity ? 2 * scratch -> free_capacity : 4;
+        scratch -> free_inds = track_realloc(scratch -> free_inds, scratch -> free_capacity * sizeof(ind_t *));
+    }
+
+    scratch -> free_inds[scratch -> free_size++] = ind;
+}
+
+/*
+ * Put random order of numbers of interval [start; end) into arr.
+ * Gives the same order as create_shuffle.
+ */
+void shuffle_into(int *arr, int start, int end) {
+    int size = end - start;
+    for (int i = start; i < end; ++i) {
+        arr[i - start] = i;
+    }
+
+    for (int i = 0; i < size; ++i) {
+        int j = randInt(0, size);
+        int tmp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = tmp;
+    }
+}
+
+/*
+ * Remove prof and all TAs from course i of genome.
+ */
+void genome_clear_course(const layout_t *layout, unsigned char *genome, int i) {
+    gene_set(layout, genome, i, -1);
+    for (int k = layout -> lab_offset[i]; k < layout -> lab_offset[i + 1]; ++k) {
+        gene_set(layout, genome, k, -1);
+    }
+}
+
+/*
+ * Put prof p into course i of genome and update prof_load.
+ * Untrained prof cannot take any other course.
+ */
+void genome_assign_prof(const layout_t *layout, unsigned char *genome, int i, int p, course_t **courses, professor_t **profs, int *prof_load) {
+    gene_set(layout, genome, i, p);
+    prof_load[p] = prof_has_course(profs[p], courses[i]) ? prof_load[p] + 1 : 2;
+}
+
+/*
+ * Randomly distribute TAs from the pool of course i over its labs in genome.
+ * Pool must have enough free capacity (see pool_capacity).
+ */
+void genome_distr_tas(const layout_t *layout, unsigned char *genome, int i, int **tas_pool, work_t *work) {
+    int k = layout -> lab_offset[i];
+
+    shuffle_into(work -> pool_order, 1, tas_pool[i][0] + 1);
+    for (int cur_ta = 0; k < layout -> lab_offset[i + 1]; ++cur_ta) {
+        int ta = tas_pool[i][work -> pool_order[cur_ta]];
+
+        for (; work -> avail_tas[ta] > 0 && k < layout -> lab_offset[i + 1]; ++k) {
+            gene_set(layout, genome, k, ta);
+            work -> avail_tas[ta]--;
+        }
+    }
+}
+
+/*
+ * Give free profs and TAs to courses of genome that are not run, visited in order of work -> order.
+ * A course gets a prof only if free TAs from its pool can cover all its labs,
+ * so capacity is never exceeded and no prof is left with a course that cannot be run.
+ * Returns number of courses that became runnable.
+ */
+int genome_fill_order(const layout_t *layout, unsigned char *genome, int P, course_t **courses, professor_t **profs, int **profs_pool, int **tas_pool, work_t *work) {
+    int C = layout -> C, filled = 0;
+
+    for (int k = 0; k < C; ++k) {
+        int i = work -> order[k];
+        if (gene_get(layout, genome, i) != -1) continue;
+        if (pool_capacity(i, tas_pool, work -> avail_tas) < courses[i] -> labs_number) {
+            stats.skipped_courses++;
+            continue;
+        }
+
+        int prof = pick_prof(i, P, profs_pool, work -> prof_load);
+        if (prof == -1) continue;
+
+        genome_assign_prof(layout, genome, i, prof, courses, profs, work -> prof_load);
+        genome_distr_tas(layout, genome, i, tas_pool, work);
+        filled++;
+    }
+
+    return filled;
+}
+
+/*
+ * Fill genome as genome_fill_order does, visiting courses in random order.
+ */
+int genome_fill(const layout_t *layout, unsigned char *genome, int P, course_t **courses, professor_t **profs, int **profs_pool, int **tas_pool, work_t *work) {
+    shuffle_into(work -> order, 0, layout -> C);
+    return genome_fill_order(layout, genome, P, courses, profs, profs_pool, tas_pool, work);
+}
+
+/*
+ * Write random possible assignment into genome.
+ */
+void distr_genome(const layout_t *layout, unsigned char *genome, int P, int T, course_t **courses, professor_t **profs, int **profs_pool, int **tas_pool, work_t *work) {
+    memset(genome, 0xFF, layout -> size);
+    work_clear(work, P, T);
+    genome_fill(layout, genome, P, courses, profs, profs_pool, tas_pool, work);
+}
+
+/*
+ * Write greedy assignment into genome: courses are filled in order of rank_courses (which must be called first),
+ * each by a trained prof if there is a free one. Only courses that rank_courses found equal are shuffled,
+ * so greedy genomes differ just in ties and in choice of people.
+ */
+void greedy_genome(const layout_t *layout, unsigned char *genome, int P, int T, course_t **courses, professor_t **profs, int **profs_pool, int **tas_pool, work_t *work) {
+    for (int k = 0; k < layout -> C; ++k) {
+        int j = randInt(work -> tie[k], k + 1);
+        work -> order[k] = work -> order[j];
+        work -> order[j] = work -> rank[k];
+    }
+
+    memset(genome, 0xFF, layout -> size);
+    work_clear(work, P, T);
+    genome_fill_order(layout, genome, P, courses, profs, profs_pool, tas_pool, work);
+}
+
+/*
+ * Check that course i of genome can stay together with already accepted courses:
+ * its prof has a free slot and all its labs are taken by free TAs who can teach it.
+ * Updates prof_load and avail_tas when the course is accepted.
+ */
+int genome_accept_course(const layout_t *layout, const unsigned char *genome, int i, course_t **courses, professor_t **profs, ta_t **tas, work_t *work) {
+    int p = gene_get(layout, genome, i);
+    int trained = prof_has_course(profs[p], courses[i]);
+    int from = layout -> lab_offset[i], to = layout -> lab_offset[i + 1];
+
+    if (work -> prof_load[p] == 2 || (!trained && work -> prof_load[p] != 0)) return 0;
+    if (to - from != courses[i] -> labs_number) return 0;
+
+    for (int k = from; k < to; ++k) {
+        int ta = gene_get(layout, genome, k);
+        if (ta == -1 || work -> avail_tas[ta] == 0 || !is_in_courses(i, tas[ta] -> courses)) {
+            // give back labs taken by this course
+            for (int l = from; l < k; ++l) {
+                work -> avail_tas[gene_get(layout, genome, l)]++;
+            }
+            return 0;
+        }
+        work -> avail_tas[ta]--;
+    }
+
+    work -> prof_load[p] = trained ? work -> prof_load[p] + 1 : 2;
+    return 1;
+}
+
+/*
+ * Repair genome: remove courses that break capacity or qualification constraints,
+ * then give free profs and TAs to courses that are not run.
+ * Used for genomes changed by operators that do not keep constraints by themselves.
+ * Returns 1 if genome was infeasible before repair.
+ */
+int repair_genome(const layout_t *layout, unsigned char *genome, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **profs_pool, int **tas_pool, work_t *work) {
+    int infeasible = 0;
+
+    work_clear(work, P, T);
+    for (int i = 0; i < layout -> C; ++i) {
+        if (gene_get(layout, genome, i) == -1) {
+            genome_clear_course(layout, genome, i);
+        } else if (!genome_accept_course(layout, genome, i, courses, profs, tas, work)) {
+            genome_clear_course(layout, genome, i);
+            infeasible = 1;
+            stats.dropped_courses++;
+        }
+    }
+
+    stats.refilled_courses += genome_fill(layout, genome, P, courses, profs, profs_pool, tas_pool, work);
+
+    if (infeasible) stats.infeasible++;
+    return infeasible;
+}
+
+/*
+ * Create child of two genomes: every course is taken from a random parent.
+ * Child can break constraints, so it is repaired.
+ */
+void cross_genomes(const layout_t *layout, const unsigned char *a, const unsigned char *b, unsigned char *child,
+                   int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **profs_pool, int **tas_pool, work_t *work) {
+    for (int i = 0; i < layout -> C; ++i) {
+        const unsigned char *parent = randInt(0, 2) ? a : b;
+
+        gene_set(layout, child, i, gene_get(layout, parent, i));
+        for (int k = layout -> lab_offset[i]; k < layout -> lab_offset[i + 1]; ++k) {
+            gene_set(layout, child, k, gene_get(layout, parent, k));
+        }
+    }
+
+    repair_genome(layout, child, P, T, courses, profs, tas, profs_pool, tas_pool, work);
+}
+
+/*
+ * Create mutant of genome: a few random courses lose prof and TAs,
+ * then repair gives free profs and TAs to random courses.
+ */
+void mutate_genome(const layout_t *layout, const unsigned char *genome, unsigned char *mutant,
+                   int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **profs_pool, int **tas_pool, work_t *work) {
+    int C = layout -> C;
+    int changes = 1 + randInt(0, maximum(1, C / 10));
+
+    memcpy(mutant, genome, layout -> size);
+    for (int k = 0; k < changes; ++k) {
+        genome_clear_course(layout, mutant, randInt(0, C));
+    }
+
+    repair_genome(layout, mutant, P, T, courses, profs, tas, profs_pool, tas_pool, work);
+}
+
+/*
+ * Canonical hash of genome, equal to ind_hash of decoded individual.
+ */
+unsigned long long genome_hash(const layout_t *layout, const unsigned char *genome) {
+    unsigned long long h = 0;
+
+    for (int i = 0; i < layout -> C; ++i) {
+        int p = gene_get(layout, genome, i);
+        if (p == -1) continue;
+
+        unsigned long long course_h = mix64(((unsigned long long) i << 32) | (unsigned) p);
+        for (int k = layout -> lab_offset[i]; k < layout -> lab_offset[i + 1];) {
+            int ta = gene_get(layout, genome, k), number = 0;
+            for (; k < layout -> lab_offset[i + 1] && gene_get(layout, genome, k) == ta; ++k) {
+                ++number;
+            }
+            if (ta == -1) continue;
+
+            course_h += mix64(((unsigned long long) (i + 1) << 40) ^ ((unsigned long long) ta << 8) ^ (unsigned) number);
+        }
+        h += mix64(course_h);
+    }
+
+    return h ? h : 1;
+}
+
+/*
+ * Number of genes in which genomes a and b differ. Labs of a course are compared as a set of TAs,
+ * so the order in which TAs are stored does not count.
+ */
+int genome_distance(const layout_t *layout, const unsigned char *a, const unsigned char *b) {
+    int distance = 0;
+
+    for (int i = 0; i < layout -> C; ++i) {
+        int from = layout -> lab_offset[i], to = layout -> lab_offset[i + 1];
+        distance += gene_get(layout, a, i) != gene_get(layout, b, i);
+
+        // labs of a are stored in runs of one TA; every run is matched with labs of the same TA in b
+        int matched = 0;
+        for (int k = from; k < to;) {
+            int ta = gene_get(layout, a, k), in_a = 0, in_b = 0;
+            for (; k < to && gene_get(layout, a, k) == ta; ++k) {
+                ++in_a;
+            }
+            for (int l = from; l < to; ++l) {
+                in_b += gene_get(layout, b, l) == ta;
+            }
+            matched += minimum(in_a, in_b);
+        }
+        distance += to - from - matched;
+    }
+
+    return distance;
+}
+
+/*
+ * Put genome into lane j of the structure of arrays.
+ * The lane must be cleared by soa_clear before.
+ */
+void soa_store_genome(soa_t *soa, int j, const layout_t *layout, const unsigned char *genome) {
+    int n = soa -> n;
+
+    for (int i = 0; i < soa -> C; ++i) {
+        int p = gene_get(layout, genome, i);
+
+        soa -> runnable[i * n + j] = p != -1;
+        if (p == -1) continue;
+
+        soa -> prof_load[p * n + j]++;
+        for (int k = layout -> lab_offset[i]; k < layout -> lab_offset[i + 1]; ++k) {
+            int ta = gene_get(layout, genome, k);
+            if (ta != -1) soa -> ta_load[ta * n + j]++;
+        }
+    }
+}
+
+/*
+ * Calculate badness points of one genome, as calculate_badness_batch does for a lane.
+ * Loads are counted in prof_load and avail_tas of work.
+ */
+int genome_badness(const layout_t *layout, const unsigned char *genome, int P, int T, course_t **courses, const int *c_studs, work_t *work) {
+    int badness = 10 * P + 8 * T, impossible = 0;
+
+    memset(work -> prof_load, 0, P * sizeof(int));
+    memset(work -> avail_tas, 0, T * sizeof(int));
+    for (int i = 0; i < layout -> C; ++i) {
+        int p = gene_get(layout, genome, i);
+        if (p == -1) {
+            badness += 20 + c_studs[i];
+            continue;
+        }
+
+        badness += maximum(0, c_studs[i] - courses[i] -> students_number) - 5;
+        impossible = impossible || ++work -> prof_load[p] > 2;
+        for (int k = layout -> lab_offset[i]; k < layout -> lab_offset[i + 1]; ++k) {
+            int ta = gene_get(layout, genome, k);
+            if (ta == -1) continue;
+
+            badness -= 2;
+            impossible = impossible || ++work -> avail_tas[ta] > 4;
+        }
+    }
+
+    return impossible ? MAX_BADNESS_POINTS : badness;
+}
+
+/*
+ * Create a random individual with pointers to courses, profs and TAs.
+ * Search works on genomes; this is used where a single individual is needed.
+ * Badness points are not calculated here.
+ */
+ind_t *create_ind(int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **profs_pool, int **tas_pool) {
+    layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+    work_t *work = create_work(C, P, T, tas_pool);
+    unsigned char *genome = malloc(layout -> size + 1);
+
+    distr_genome(layout, genome, P, T, courses, profs, profs_pool, tas_pool, work);
+    ind_t *ind = decode_ind(layout, genome, courses, profs, tas);
+
+    free(genome);
+    free_work(work);
+    free_layout(layout);
+    return ind;
+}
+
+/*
+ * Choose best_size best genomes of population and move them to the beginning in order of badness.
+ * Among equal genomes the earlier one wins.
+ */
+void choose_best_genomes(cpop_t *pop, int best_size) {
+    int outer = perf_phase(PHASE_SELECTION);
+    int n = pop -> n;
+    size_t size = pop -> layout -> size;
+    char *was = pop -> chosen;
+    int *best = pop -> order;
+
+    memset(was, 0, (size_t) n);
+    if (pop -> spare_size < best_size) {
+        pop -> spare_size = best_size;
+        pop -> spare_genomes = track_realloc(pop -> spare_genomes, best_size * size + 1);
+        pop -> spare_badness = track_realloc(pop -> spare_badness, best_size * sizeof(int));
+        pop -> spare_hash = track_realloc(pop -> spare_hash, best_size * sizeof(unsigned long long));
+    }
+
+    for (int i = 0; i < best_size; ++i) {
+        int cur_best_i = -1;
+        for (int j = 0; j < n; ++j) {
+            if (!was[j] && (cur_best_i == -1 || pop -> badness[j] < pop -> badness[cur_best_i])) cur_best_i = j;
+        }
+        best[i] = cur_best_i;
+        was[cur_best_i] = 1;
+    }
+
+    unsigned char *genomes = pop -> spare_genomes;
+    int *badness = pop -> spare_badness;
+    unsigned long long *hashes = pop -> spare_hash;
+    for (int i = 0; i < best_size; ++i) {
+        memcpy(genomes + i * size, cpop_genome(pop, best[i]), size);
+        badness[i] = pop -> badness[best[i]];
+        hashes[i] = pop -> hash[best[i]];
+    }
+    memcpy(pop -> genomes, genomes, best_size * size);
+    memcpy(pop -> badness, badness, best_size * sizeof(int));
+    memcpy(pop -> hash, hashes, best_size * sizeof(unsigned long long));
+    perf_phase(outer);
+}
+
+/*
+ * Calculate badness points of genomes [from, to) of population, whose hashes are already set.
+ * Duplicates of already scored genomes take badness from cache.
+ * New genomes are decoded into recycled individuals and offered to archive if it is not NULL.
+ */
+void score_genomes(cpop_t *pop, int from, int to, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int *c_studs,
+                   scratch_t *scratch, fcache_t *cache, archive_t *archive) {
+    const layout_t *layout = pop -> layout;
+    soa_t *soa = scratch -> soa;
+    int *lanes = scratch -> lanes;
+
+    for (int start = from; start < to; start += SOA_BLOCK) {
+        int end = start + SOA_BLOCK < to ? start + SOA_BLOCK : to;
+        int used = 0;
+
+        soa_clear(soa);
+        for (int j = start; j < end; ++j) {
+            if ((pop -> badness[j] = fcache_get(cache, pop -> hash[j])) == -1) {
+                soa_store_genome(soa, used, layout, cpop_genome(pop, j));
+                lanes[used++] = j;
+            }
+        }
+
+        if (used == 0) continue;
+        calculate_badness_batch(soa, courses, c_studs);
+        for (int k = 0; k < used; ++k) {
+            int j = lanes[k];
+            pop -> badness[j] = soa -> badness[k];
+            fcache_put(cache, pop -> hash[j], soa -> badness[k]);
+
+            if (archive == NULL) continue;
+            ind_t *ind = reuse_ind(scratch, layout, cpop_genome(pop, j), courses, profs, tas);
+            ind -> badness_points = pop -> badness[j];
+            archive_add(archive, layout -> C, P, T, ind, c_studs);
+            recycle_ind(scratch, ind);
+        }
+    }
+
+    stats.individuals += to - from;
+    for (int j = from; j < to; ++j) {
+        if (pop -> badness[j] == MAX_BADNESS_POINTS) stats.wasted++;
+    }
+}
+
+/*
+ * Create genome j of population: kids of random pairs of the first parents genomes,
+ * then mutants of random parents, then new random genomes. Without parents (population zero)
+ * the first greedy_percent percent are greedy (see greedy_genome), the rest are random.
+ */
+void breed_genome(const config_t *cfg, cpop_t *pop, int j, int parents, int P, int T, course_t **courses, professor_t **profs, ta_t **tas,
+                  int **profs_pool, int **tas_pool, work_t *work) {
+    const layout_t *layout = pop -> layout;
+    unsigned char *genome = cpop_genome(pop, j);
+
+    if (parents > 0 && j < cfg -> best_size + cfg -> kids_size)
+        cross_genomes(layout, cpop_genome(pop, randInt(0, parents)), cpop_genome(pop, randInt(0, parents)), genome,
+                      P, T, courses, profs, tas, profs_pool, tas_pool, work);
+    else if (parents > 0 && j < cfg -> best_size + cfg -> kids_size + cfg -> mutation_size)
+        mutate_genome(layout, cpop_genome(pop, randInt(0, parents)), genome, P, T, courses, profs, tas, profs_pool, tas_pool, work);
+    else if (parents == 0 && j < (long long) pop -> n * cfg -> greedy_percent / 100) {
+        greedy_genome(layout, genome, P, T, courses, profs, profs_pool, tas_pool, work);
+        stats.greedy++;
+    } else
+        distr_genome(layout, genome, P, T, courses, profs, profs_pool, tas_pool, work);
+
+    pop -> hash[j] = genome_hash(layout, genome);
+}
+
+/*
+ * Fill genomes [parents, n) of population with bred genomes (see breed_genome) and score them, SOA_BLOCK at a time.
+ * If a genome reaches bound (badness points no one can beat, -1 if unknown), the rest are not bred:
+ * they get MAX_BADNESS_POINTS, and 1 is returned.
+ */
+int fill_population(const config_t *cfg, cpop_t *pop, int parents, int P, int T, course_t **courses, professor_t **profs, ta_t **tas,
+                    int **profs_pool, int **tas_pool, int *c_studs, scratch_t *scratch, fcache_t *cache, archive_t *archive, int bound) {
+    int reached = 0, outer = perf_phase(PHASE_GENERATION);
+
+    if (parents == 0 && cfg -> greedy_percent > 0) rank_courses(scratch -> work, pop -> layout -> C, courses, tas_pool, c_studs);
+    for (int start = parents; start < pop -> n; start += SOA_BLOCK) {
+        int end = start + SOA_BLOCK < pop -> n ? start + SOA_BLOCK : pop -> n;
+
+        if (reached) {
+            for (int j = start; j < end; ++j) {
+                pop -> badness[j] = MAX_BADNESS_POINTS;
+                pop -> hash[j] = 0;
+            }
+            continue;
+        }
+
+        for (int j = start; j < end; ++j) {
+            breed_genome(cfg, pop, j, parents, P, T, courses, profs, tas, profs_pool, tas_pool, scratch -> work);
+        }
+        score_genomes(pop, start, end, P, T, courses, profs, tas, c_studs, scratch, cache, archive);
+
+        for (int j = start; j < end; ++j) {
+            if (pop -> badness[j] <= bound) reached = 1;
+        }
+    }
+
+    perf_phase(outer);
+    return reached;
+}
+
+/*
+ * Struct that is used for returning information about token in nextToken function.
+ */
+struct flag_s {
+    short contains_digits: 1;
+    short contains_letters: 1;
+    short last_token: 1;
+    short contains_invalid_symbs: 1;
+    int length;
+};
+
+/*
+ * Set flag's fields to default values.
+ */
+void clearFlag(struct flag_s *flag) {
+    flag -> contains_digits = 0;
+    flag -> contains_letters = 0;
+    flag -> last_token = 0;
+    flag -> contains_invalid_symbs = 0;
+    flag -> length = 0;
+}
+
+/*
+ * Put a part of given line until a space to buffer.
+ * Also put flags to flag structure.
+ */
+char *nextToken(char* buf, size_t size, char *line, struct flag_s *flag) {
+    int i = 0;
+    for (i = 0; i < size - 1 && line[i] != '\0' && line[i] != ' ' && line[i] != '\n'; ++i) {
+        buf[i] = line[i];
+        flag -> contains_digits = flag -> contains_digits || isDigit(line[i]);
+        flag -> contains_letters = flag -> contains_letters || isLetter(line[i]);
+        flag -> contains_invalid_symbs = flag -> contains_invalid_symbs || !isValid(line[i]);
+    }
+
+    buf[i] = '\0';
+    flag -> length = i;
+    flag -> last_token = line[i] == '\0' || line[i] == '\n';
+    if ((buf[0] == 'P' || buf[0] == 'T' || buf[0] == 'S') && buf[1] == '\0') flag -> contains_invalid_symbs = 1;
+    return line + i + 1;
+}
+
+/*
+ * Convert string to integer.
+ * If any error -> return -1.
+ */
+int strtint(const char str[]) {
+    int i = 0;
+    int num = 0;
+    while (str[i]) {
+        if (i == 1 && num == 0)
+            return -1;
+        num = num * 10 + str[i] - '0';
+        i++;
+    }
+
+    return i != 0 && num != 0 ? num : -1;
+}
+
+/*
+ * Get course from string.
+ */
+course_t *get_c_line(int id, char *line, chash_t *chash) {
+    char *name = malloc(BUFFER_SIZE);
+    int labs_number = 0, students_number = 0;
+    int error = 0, last_token = 0;
+    char *buffer = malloc(BUFFER_SIZE);
+    struct flag_s *flag = malloc(sizeof(struct flag_s));
+    clearFlag(flag);
+    int state = NAME;
+
+    while (!last_token) {
+        line = nextToken(buffer, BUFFER_SIZE, line, flag);
+        if (state == NAME) {
+            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
+                error = 1;
+                break;
+            }
+            strcpy(name, buffer);
+        } else if (state == LABS) {
+            if (flag -> contains_letters || flag -> contains_invalid_symbs || (labs_number = strtint(buffer)) == -1) {
+                error = 1;
+                break;
+            }
+        } else if (state == STUDENTS) {
+            if (flag -> contains_letters || flag -> contains_invalid_symbs || (students_number = strtint(buffer)) == -1) {
+                error = 1;
+                break;
+            }
+        } else if (state == END) {
+            error = 1;
+            break;
+        }
+        last_token = flag -> last_token;
+        clearFlag(flag);
+        state++;
+    }
+
+    course_t *course = create_course(id, name, labs_number, students_number);
+    if (addCourseToHashTable(chash, course)) error = 1;
+
+    free(buffer);
+    free(flag);
+
+    if (state != END || error) {
+        free(name);
+        free(course);
+        return NULL;
+    }
+
+    return course;
+}
+
+/*
+ * Make course list (0-th element is the size) able to store one more course.
+ * Capacity is doubled when the list is full.
+ */
+int *reserve_course(int *courses, int *capacity) {
+    if (courses[0] < *capacity) return courses;
+
+    *capacity *= 2;
+    return realloc(courses, (size_t) (*capacity + 1) * sizeof(int));
+}
+
+/*
+ * Get professor from string.
+ */
+professor_t *get_p_line(int id, char *line, chash_t *chash, phash_t *phash) {
+    int statesShifts[] = {P_SURNAME, P_COURSES, P_COURSES};
+
+    char *name = malloc(2 * BUFFER_SIZE); // name, space and surname
+    char *surname = name;
+    int capacity = MAX_COURSES; // list grows when full
+    int *courses = malloc(sizeof(int) * (capacity + 1));
+    courses[0] = 0; // 0-th <- number of courses
+
+    int state = P_NAME;
+    char *buffer = malloc(BUFFER_SIZE);
+    int error = 0, last_token = 0;
+    struct flag_s *flag = malloc(sizeof(struct flag_s));
+    clearFlag(flag);
+
+    while (!last_token) {
+        line = nextToken(buffer, BUFFER_SIZE, line, flag);
+        if (state == P_NAME) {
+            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
+                error = 1;
+                break;
+            }
+            strcpy(name, buffer);
+            name[flag -> length] = ' ';
+            surname = name + flag -> length + 1;
+        } else if (state == P_SURNAME) {
+            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
+                error = 1;
+                break;
+            }
+            strcpy(surname, buffer);
+        } else if (state == P_COURSES) {
+            int courseId;
+            if (flag -> contains_digits || flag -> contains_invalid_symbs || (courseId = getCourseIdFromHashTable(chash, buffer)) == -1) {
+                error = 1;
+                break;
+            }
+
+            courses = reserve_course(courses, &capacity);
+            courses[++courses[0]] = courseId;
+        }
+
+        last_token = flag -> last_token;
+        clearFlag(flag);
+        state = statesShifts[state];
+    }
+
+    free(flag);
+    free(buffer);
+
+    professor_t *professor = create_professor(id, name, courses);
+
+    if (addProfToHashTable(phash, professor)) error = 1;
+
+
+    if (courses[0] == 0 || state != P_COURSES || error) {
+        free(name);
+        free(courses);
+        free(professor);
+        return NULL;
+    }
+
+    return professor;
+}
+
+/*
+ * Get TA from string.
+ */
+ta_t *get_t_line(int id, char *line, chash_t *chash, thash_t *thash) {
+    int statesShifts[] = {P_SURNAME, P_COURSES, P_COURSES};
+
+    char *name = malloc(2 * BUFFER_SIZE); // name, space and surname
+    char *surname = name;
+    int capacity = MAX_COURSES; // list grows when full
+    int *courses = malloc(sizeof(int) * (capacity + 1));
+    courses[0] = 0; // 0-th <- number of courses
+
+    int state = P_NAME;
+    char *buffer = malloc(BUFFER_SIZE);
+    int error = 0, last_token = 0;
+    struct flag_s *flag = malloc(sizeof(struct flag_s));
+    clearFlag(flag);
+
+    while (!last_token) {
+        line = nextToken(buffer, BUFFER_SIZE, line, flag);
+        if (state == P_NAME) {
+            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
+                error = 1;
+                break;
+            }
+            strcpy(name, buffer);
+            name[flag -> length] = ' ';
+            surname = name + flag -> length + 1;
+        } else if (state == P_SURNAME) {
+            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
+                error = 1;
+                break;
+            }
+            strcpy(surname, buffer);
+        } else if (state == P_COURSES) {
+            int courseId;
+            if (flag -> contains_digits || flag -> contains_invalid_symbs || (courseId = getCourseIdFromHashTable(chash, buffer)) == -1) {
+                error = 1;
+                break;
+            }
+
+            courses = reserve_course(courses, &capacity);
+            courses[++courses[0]] = courseId;
+        }
+
+        last_token = flag -> last_token;
+        clearFlag(flag);
+        state = statesShifts[state];
+    }
+
+    free(flag);
+    free(buffer);
+
+    ta_t *ta = create_ta(id, name, courses);
+
+    if (addTaToHashTable(thash, ta)) error = 1;
+
+
+    if (courses[0] == 0 || state != P_COURSES || error) {
+        free(name);
+        free(courses);
+        free(ta);
+        return NULL;
+    }
+
+    return ta;
+}
+
+/*
+ * Hashtable used for storing codes of all students.
+ * Unlike other tables it grows, so the number of students is not limited by TABLE_SIZE.
+ */
+typedef struct codes_hashtable_s {
+    int size; // power of two
+    int used;
+    char **codes;
+} shash_t;
+
+/*
+ * Creates new empty hash table of codes.
+ */
+shash_t *create_codes_hashtable() {
+    shash_t *codes_hashtable = malloc(sizeof(shash_t));
+
+    codes_hashtable -> size = TABLE_SIZE;
+    codes_hashtable -> used = 0;
+    codes_hashtable -> codes = calloc(TABLE_SIZE, sizeof(char *));
+
+    return codes_hashtable;
+}
+
+/*
+ * Free space that was used by hash table of codes. Codes are owned by roster of students.
+ */
+void free_codes_hashtable(shash_t *codes_hashtable) {
+    free(codes_hashtable -> codes);
+    free(codes_hashtable);
+}
+
+/*
+ * Remove all codes from hashtable, keeping its size.
+ */
+void clearCodesHashTable(shash_t *s_hash) {
+    memset(s_hash -> codes, 0, s_hash -> size * sizeof(char *));
+    s_hash -> used = 0;
+}
+
+/*
+ * Put code into table without checking size. If the code is already there: 1; otherwise: 0
+ */
+int insertCode(shash_t *s_hash, char *code) {
+    int i = (int) (mix64((unsigned long long) hash(code)) & (s_hash -> size - 1));
+
+    for (; s_hash -> codes[i] != NULL; i = (i + 1) & (s_hash -> size - 1)) {
+        if (!compare_str(s_hash -> codes[i], code)) return 1;
+    }
+
+    s_hash -> codes[i] = code;
+    s_hash -> used++;
+    return 0;
+}
+
+/*
+ * Add a code to hashtable. If the code is not unique: 1; otherwise: 0
+ */
+int addCodeToHashTable(shash_t *s_hash, char *code) {
+    if (2 * (s_hash -> used + 1) > s_hash -> size) {
+        char **old_codes = s_hash -> codes;
+        int old_size = s_hash -> size;
+
+        s_hash -> size *= 2;
+        s_hash -> used = 0;
+        s_hash -> codes = calloc((size_t) s_hash -> size, sizeof(char *));
+        for (int i = 0; i < old_size; ++i) {
+            if (old_codes[i] != NULL) insertCode(s_hash, old_codes[i]);
+        }
+        free(old_codes);
+    }
+
+    return insertCode(s_hash, code);
+}
+
+/*
+ * Parse student from string and append them to roster. Uniqueness of code is checked by caller.
+ * If line is invalid: 1 and roster is not changed; otherwise: 0
+ */
+int get_s_line(char *line, chash_t *chash, roster_t *roster) {
+    int statesShifts[] = {S_SURNAME, S_CODE, S_COURSES, S_COURSES};
+    int ids_size = roster -> ids_size;
+    size_t text_size = roster -> text_size;
+
+    int state = S_NAME; // used for smart error handling
+    char buffer[BUFFER_SIZE]; // buffer for scanning
+    int error = 0, last_token = 0;
+    struct flag_s flag;
+    clearFlag(&flag);
+    roster_begin(roster);
+
+    while (!last_token) {
+        line = nextToken(buffer, BUFFER_SIZE, line, &flag);
+        if (state == S_NAME || state == S_SURNAME) {
+            if (flag.contains_digits || flag.contains_invalid_symbs) {
+                error = 1;
+                break;
+            }
+            roster_put_text(roster, buffer, (size_t) flag.length, state == S_NAME ? ' ' : '\0'); // name and surname are merged
+        } else if (state == S_CODE) {
+            if (flag.length != 5 || flag.contains_invalid_symbs) {
+                error = 1;
+                break;
+            }
+
+            roster_put_code(roster, buffer);
+        } else if (state == S_COURSES) {
+            int courseId;
+            if (flag.contains_digits || flag.contains_invalid_symbs ||
+                (courseId = getCourseIdFromHashTable(chash, buffer)) == -1) {
+                error = 1;
+                break;
+            }
+
+            roster_put_course(roster, courseId);
+        }
+
+        last_token = flag.last_token;
+        clearFlag(&flag);
+        state = statesShifts[state];
+    }
+
+    // if 0 courses or we did not reach courses or some error
+    if (roster -> count[roster -> S] == 0 || state != S_COURSES || error) {
+        roster -> ids_size = ids_size;
+        roster -> text_size = text_size;
+        return 1;
+    }
+
+    roster_end(roster);
+    return 0;
+}
+
+/*
+ * Lines of students section stored one after another, read before they are parsed.
+ */
+typedef struct lines_s {
+    int n;
+    int capacity;
+    size_t *offsets; // offsets[k] = start of line k in text
+    char *text;
+    size_t used;
+    size_t size;
+} lines_t;
+
+/*
+ * Create empty storage of lines.
+ */
+lines_t *create_lines() {
+    lines_t *lines = malloc(sizeof(lines_t));
+
+    lines -> n = 0;
+    lines -> capacity = MAX_STUDENTS;
+    lines -> offsets = malloc(lines -> capacity * sizeof(size_t));
+    lines -> used = 0;
+    lines -> size = BUFFER_SIZE * MAX_STUDENTS;
+    lines -> text = malloc(lines -> size);
+
+    return lines;
+}
+
+/*
+ * Free space that was used by lines.
+ */
+void free_lines(lines_t *lines) {
+    free(lines -> offsets);
+    free(lines -> text);
+    free(lines);
+}
+
+/*
+ * Remove all lines, keeping allocated space.
+ */
+void clear_lines(lines_t *lines) {
+    lines -> n = 0;
+    lines -> used = 0;
+}
+
+/*
+ * Append a copy of line.
+ */
+void add_line(lines_t *lines, const char *line) {
+    size_t length = strlen(line) + 1;
+
+    if (lines -> n == lines -> capacity) {
+        lines -> capacity *= 2;
+        lines -> offsets = realloc(lines -> offsets, lines -> capacity * sizeof(size_t));
+    }
+    while (lines -> used + length > lines -> size) {
+        lines -> size *= 2;
+        lines -> text = realloc(lines -> text, lines -> size);
+    }
+
+    memcpy(lines -> text + lines -> used, line, length);
+    lines -> offsets[lines -> n++] = lines -> used;
+    lines -> used += length;
+}
+
+/*
+ * Part of students section parsed by one thread.
+ */
+typedef struct parse_task_s {
+    lines_t *lines;
+    int from;
+    int to;
+    chash_t *chash;
+    roster_t *roster; // students of the task
+} parse_task_t;
+
+/*
+ * Parse lines [from, to) of task into its roster without checking uniqueness of codes, up to the first invalid line.
+ * Thread function.
+ */
+void *parse_students_chunk(void *arg) {
+    parse_task_t *task = arg;
+
+    for (int k = task -> from; k < task -> to; ++k) {
+        if (get_s_line(task -> lines -> text + task -> lines -> offsets[k], task -> chash, task -> roster)) break;
+    }
+
+    return NULL;
+}
+
+/*
+ * Number of threads to use: cfg_threads or, if it is 0, number of processors.
+ */
+int count_threads(int cfg_threads) {
+    int threads = cfg_threads > 0 ? cfg_threads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    return threads < MAX_THREADS ? threads : MAX_THREADS;
+}
+
+/*
+ * Threads that wait for tasks and run them, kept between calls of solve.
+ */
+typedef struct worker_pool_s {
+    int workers; // threads besides the caller
+    pthread_t *ids;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    void *(*fn)(void *);
+    char *args; // arguments of tasks, arg_size bytes each
+    size_t arg_size;
+    int tasks;
+    int next; // next task to take
+    int done;
+    int stop;
+} pool_t;
+
+/*
+ * Take tasks of pool until there are none. Called with pool -> lock held.
+ */
+void run_pool_tasks(pool_t *pool) {
+    while (pool -> next < pool -> tasks) {
+        int task = pool -> next++;
+
+        pthread_mutex_unlock(&pool -> lock);
+        pool -> fn(pool -> args + task * pool -> arg_size);
+        pthread_mutex_lock(&pool -> lock);
+
+        if (++pool -> done == pool -> tasks) pthread_cond_broadcast(&pool -> work_done);
+    }
+}
+
+/*
+ * Thread function of workers of pool.
+ */
+void *pool_worker(void *arg) {
+    pool_t *pool = arg;
+
+    pthread_mutex_lock(&pool -> lock);
+    while (!pool -> stop) {
+        if (pool -> next < pool -> tasks) run_pool_tasks(pool);
+        else pthread_cond_wait(&pool -> work_ready, &pool -> lock);
+    }
+    pthread_mutex_unlock(&pool -> lock);
+
+    return NULL;
+}
+
+/*
+ * Create pool that runs tasks on threads threads, including the calling one.
+ */
+pool_t *create_pool(int threads) {
+    pool_t *pool = calloc(1, sizeof(pool_t));
+
+    pthread_mutex_init(&pool -> lock, NULL);
+    pthread_cond_init(&pool -> work_ready, NULL);
+    pthread_cond_init(&pool -> work_done, NULL);
+    pool -> ids = malloc(threads * sizeof(pthread_t));
+    for (int t = 0; t < threads - 1; ++t) {
+        if (pthread_create(&pool -> ids[t], NULL, pool_worker, pool) != 0) break;
+        pool -> workers++;
+    }
+
+    return pool;
+}
+
+/*
+ * Stop workers of pool and free it.
+ */
+void free_pool(pool_t *pool) {
+    pthread_mutex_lock(&pool -> lock);
+    pool -> stop = 1;
+    pthread_cond_broadcast(&pool -> work_ready);
+    pthread_mutex_unlock(&pool -> lock);
+
+    for (int t = 0; t < pool -> workers; ++t) {
+        pthread_join(pool -> ids[t], NULL);
+    }
+
+    pthread_cond_destroy(&pool -> work_done);
+    pthread_cond_destroy(&pool -> work_ready);
+    pthread_mutex_destroy(&pool -> lock);
+    free(pool -> ids);
+    free(pool);
+}
+
+/*
+ * Run fn on tasks arguments stored one after another in args (arg_size bytes each) and wait for all of them.
+ * Calling thread runs tasks too.
+ */
+void pool_run(pool_t *pool, int tasks, void *(*fn)(void *), void *args, size_t arg_size) {
+    pthread_mutex_lock(&pool -> lock);
+    pool -> fn = fn;
+    pool -> args = args;
+    pool -> arg_size = arg_size;
+    pool -> tasks = tasks;
+    pool -> next = 0;
+    pool -> done = 0;
+    pthread_cond_broadcast(&pool -> work_ready);
+
+    run_pool_tasks(pool);
+    while (pool -> done < tasks) {
+        pthread_cond_wait(&pool -> work_done, &pool -> lock);
+    }
+    pool -> tasks = 0;
+    pool -> next = 0;
+    pthread_mutex_unlock(&pool -> lock);
+}
+
+/*
+ * Parse all lines of students section into empty roster.
+ * Lines are split into chunks parsed on threads into rosters of their own, then merged in input order,
+ * and codes are checked for uniqueness after merging. Parsing stops at the first line
+ * that is invalid or repeats a code, exactly as if lines were parsed one by one.
+ * Returns number of students before that line; *error = 1 if there is such line.
+ */
+int parse_students(lines_t *lines, chash_t *chash, shash_t *shash, pool_t *pool, roster_t *roster, int *error) {
+    int n = lines -> n;
+    int threads = n < PARSE_CHUNK_LINES ? 1 : pool -> workers + 1;
+    parse_task_t *tasks = malloc(threads * sizeof(parse_task_t));
+
+    for (int t = 0; t < threads; ++t) {
+        tasks[t].lines = lines;
+        tasks[t].from = (int) ((long long) n * t / threads);
+        tasks[t].to = (int) ((long long) n * (t + 1) / threads);
+        tasks[t].chash = chash;
+        tasks[t].roster = t == 0 ? roster : create_roster();
+    }
+    if (threads == 1) parse_students_chunk(&tasks[0]);
+    else pool_run(pool, threads, parse_students_chunk, tasks, sizeof(parse_task_t));
+
+    for (int t = 1; t < threads; ++t) {
+        if (roster -> S == tasks[t].from) roster_append(roster, tasks[t].roster); // all lines before chunk are valid
+        free_roster(tasks[t].roster);
+    }
+
+    // codes point into string pool, which does not move until change lists add students
+    int S = 0;
+    for (; S < roster -> S; ++S) {
+        if (addCodeToHashTable(shash, roster_code(roster, S))) break;
+    }
+
+    *error = S < n;
+    roster_cut(roster, S);
+
+    free(tasks);
+    return S;
+}
+
+/*
+ * Count different hashes among n hashes.
+ */
+long long count_distinct(int n, const unsigned long long *hashes) {
+    unsigned long long *sorted = malloc(n * sizeof(unsigned long long));
+    long long distinct = 0;
+
+    memcpy(sorted, hashes, n * sizeof(unsigned long long));
+    qsort(sorted, n, sizeof(unsigned long long), compare_hashes);
+    for (int i = 0; i < n; ++i) {
+        if (i == 0 || sorted[i] != sorted[i - 1]) ++distinct;
+    }
+
+    free(sorted);
+    return distinct;
+}
+
+/*
+ * Write assignment of course i of genome in the same form as encode_assignment:
+ * "-" if course is not run, otherwise "prof/ta:labs,ta:labs".
+ */
+void write_course_token(FILE *out, const layout_t *layout, const unsigned char *genome, int i) {
+    int p = gene_get(layout, genome, i);
+    if (p == -1) {
+        fprintf(out, "-");
+        return;
+    }
+
+    fprintf(out, "%d/", p);
+    for (int k = layout -> lab_offset[i], first = 1; k < layout -> lab_offset[i + 1]; first = 0) {
+        int ta = gene_get(layout, genome, k), number = 0;
+        for (; k < layout -> lab_offset[i + 1] && gene_get(layout, genome, k) == ta; ++k) {
+            ++number;
+        }
+        fprintf(out, first ? "%d:%d" : ",%d:%d", ta, number);
+    }
+}
+
+/*
+ * Check if course i is assigned in the same way in two genomes.
+ */
+int same_course(const layout_t *layout, const unsigned char *a, const unsigned char *b, int i) {
+    if (gene_get(layout, a, i) != gene_get(layout, b, i)) return 0;
+    for (int k = layout -> lab_offset[i]; k < layout -> lab_offset[i + 1]; ++k) {
+        if (gene_get(layout, a, k) != gene_get(layout, b, k)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * If the best genome of population is better than the last written one (streamed), write it into out
+ * as one line: unix time, CPU seconds, generation, badness and "course=token" for every course
+ * that changed since the last written genome (all courses for the first one).
+ * Line is flushed at once, so another process can read it from a pipe.
+ */
+void stream_best(FILE *out, cpop_t *pop, unsigned char *streamed, int *streamed_badness, int generation, double cpu_seconds) {
+    const layout_t *layout = pop -> layout;
+    int best = 0;
+
+    for (int j = 1; j < pop -> n; ++j) {
+        if (pop -> badness[j] < pop -> badness[best]) best = j;
+    }
+    if (pop -> badness[best] >= *streamed_badness) return;
+
+    const unsigned char *genome = cpop_genome(pop, best);
+    fprintf(out, "%lld %.3f %d %d", (long long) time(NULL), cpu_seconds, generation, pop -> badness[best]);
+    for (int i = 0; i < layout -> C; ++i) {
+        if (*streamed_badness != MAX_BADNESS_POINTS && same_course(layout, genome, streamed, i)) continue;
+
+        fprintf(out, " %d=", i);
+        write_course_token(out, layout, genome, i);
+    }
+    fprintf(out, "\n");
+    fflush(out);
+
+    memcpy(streamed, genome, layout -> size);
+    *streamed_badness = pop -> badness[best];
+    stats.improvements++;
+}
+
+/*
+ * Fixed part of checkpoint file. It is followed by genomes, badness and hashes of population.
+ */
+typedef struct checkpoint_header_s {
+    unsigned magic;
+    unsigned version;
+    unsigned long long fingerprint; // see instance_fingerprint
+    int genes;
+    int wide;
+    int population_size;
+    int best_size;
+    int kids_size;
+    int mutation_size;
+    int generations_number;
+    int generation; // next generation to do
+    int best_index; // best genome found so far
+    int best_badness;
+    unsigned long long rng_state;
+    double cpu_seconds; // CPU time spent before checkpoint
+    stats_t stats;
+} ckpt_header_t;
+
+/*
+ * State of genetic algorithm read from checkpoint file.
+ */
+typedef struct checkpoint_s {
+    ckpt_header_t header;
+    unsigned char *genomes;
+    int *badness;
+    unsigned long long *hash;
+} ckpt_t;
+
+/*
+ * Hash of everything that checkpoint depends on: sizes, courses, pools and enrollments.
+ */
+unsigned long long instance_fingerprint(int C, int P, int T, course_t **courses, int **profs_pool, int **tas_pool, const int *c_studs) {
+    unsigned long long h = mix64(((unsigned long long) C << 40) ^ ((unsigned long long) P << 20) ^ (unsigned long long) T);
+
+    for (int i = 0; i < C; ++i) {
+        h = mix64(h ^ (unsigned long long) hash(courses[i] -> name));
+        h = mix64(h ^ ((unsigned long long) courses[i] -> labs_number << 32) ^ (unsigned) courses[i] -> students_number);
+        h = mix64(h ^ (unsigned) c_studs[i]);
+        for (int k = 1; k < profs_pool[i][0] + 1; ++k) {
+            h = mix64(h ^ ((unsigned long long) 1 << 32) ^ (unsigned) profs_pool[i][k]);
+        }
+        for (int k = 1; k < tas_pool[i][0] + 1; ++k) {
+            h = mix64(h ^ ((unsigned long long) 2 << 32) ^ (unsigned) tas_pool[i][k]);
+        }
+    }
+
+    return h;
+}
+
+/*
+ * Write state of genetic algorithm before generation into file name.
+ * File is written under temporary name and renamed, so a killed run never leaves a broken checkpoint.
+ * If any error -> return 1.
+ */
+int write_checkpoint(const char *name, const config_t *cfg, cpop_t *pop, const fcache_t *cache, unsigned long long fingerprint, int generation, double cpu_seconds) {
+    char tmp_name[CHECKPOINT_NAME_SIZE + 4];
+    ckpt_header_t header;
+    size_t n = (size_t) pop -> n;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.fingerprint = fingerprint;
+    header.genes = pop -> layout -> genes;
+    header.wide = pop -> layout -> wide;
+    header.population_size = cfg -> population_size;
+    header.best_size = cfg -> best_size;
+    header.kids_size = cfg -> kids_size;
+    header.mutation_size = cfg -> mutation_size;
+    header.generations_number = cfg -> generations_number;
+    header.generation = generation;
+    header.rng_state = rng.state;
+    header.cpu_seconds = cpu_seconds;
+    header.stats = stats;
+    header.stats.cache_lookups += cache -> lookups;
+    header.stats.cache_hits += cache -> hits;
+    for (int j = 0; j < pop -> n; ++j) {
+        if (pop -> badness[j] < pop -> badness[header.best_index]) header.best_index = j;
+    }
+    header.best_badness = pop -> badness[header.best_index];
+
+    sprintf(tmp_name, "%s.tmp", name);
+    FILE *file = fopen(tmp_name, "wb");
+    if (file == NULL) return 1;
+
+    int error = fwrite(&header, sizeof(header), 1, file) != 1 ||
+                fwrite(pop -> genomes, pop -> layout -> size, n, file) != n ||
+                fwrite(pop -> badness, sizeof(int), n, file) != n ||
+                fwrite(pop -> hash, sizeof(unsigned long long), n, file) != n;
+    error = fclose(file) != 0 || error;
+
+    if (error || rename(tmp_name, name) != 0) {
+        remove(tmp_name);
+        return 1;
+    }
+
+    stats.checkpoints++;
+    return 0;
+}
+
+/*
+ * Free space that was used by checkpoint.
+ */
+void free_checkpoint(ckpt_t *ckpt) {
+    free(ckpt -> genomes);
+    free(ckpt -> badness);
+    free(ckpt -> hash);
+    free(ckpt);
+}
+
+/*
+ * Read checkpoint of instance from file name.
+ * Returns NULL if there is no file or it was written for another instance or version.
+ */
+ckpt_t *read_checkpoint(const char *name, const layout_t *layout, unsigned long long fingerprint) {
+    FILE *file = fopen(name, "rb");
+    if (file == NULL) return NULL;
+
+    ckpt_t *ckpt = calloc(1, sizeof(ckpt_t));
+    ckpt_header_t *header = &ckpt -> header;
+    if (fread(header, sizeof(ckpt_header_t), 1, file) != 1 || header -> magic != CHECKPOINT_MAGIC ||
+        header -> version != CHECKPOINT_VERSION || header -> fingerprint != fingerprint ||
+        header -> genes != layout -> genes || header -> wide != layout -> wide ||
+        header -> population_size < 1 || header -> population_size > MAX_POPULATION_SIZE) {
+        fclose(file);
+        free_checkpoint(ckpt);
+        return NULL;
+    }
+
+    size_t n = (size_t) header -> population_size;
+    ckpt -> genomes = malloc(n * layout -> size + 1);
+    ckpt -> badness = malloc(n * sizeof(int));
+    ckpt -> hash = malloc(n * sizeof(unsigned long long));
+    int error = fread(ckpt -> genomes, layout -> size, n, file) != n ||
+                fread(ckpt -> badness, sizeof(int), n, file) != n ||
+                fread(ckpt -> hash, sizeof(unsigned long long), n, file) != n;
+    fclose(file);
+
+    if (error) {
+        free_checkpoint(ckpt);
+        return NULL;
+    }
+
+    return ckpt;
+}
+
+/*
+ * Take sizes of genetic algorithm from checkpoint, so resumed run continues the same search.
+ */
+void apply_checkpoint_config(config_t *cfg, const ckpt_t *ckpt) {
+    cfg -> population_size = ckpt -> header.population_size;
+    cfg -> best_size = ckpt -> header.best_size;
+    cfg -> kids_size = ckpt -> header.kids_size;
+    cfg -> mutation_size = ckpt -> header.mutation_size;
+    cfg -> generations_number = ckpt -> header.generations_number;
+}
+
+/*
+ * Root of course in union-find forest of components, with path halving.
+ */
+int component_root(int *parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+/*
+ * Split courses into components: courses are in one component if they are linked by profs and TAs qualified for them.
+ * Sets component[i] of every course (numbered in order of first courses) and returns number of components.
+ */
+int find_components(int C, int P, int T, professor_t **profs, ta_t **tas, int *component) {
+    int *parent = malloc((C + 1) * sizeof(int));
+    for (int i = 0; i < C; ++i) {
+        parent[i] = i;
+    }
+
+    for (int q = 0; q < P + T; ++q) {
+        int *courses = q < P ? profs[q] -> courses : tas[q - P] -> courses;
+        for (int j = 2; j < courses[0] + 1; ++j) {
+            parent[component_root(parent, courses[j])] = component_root(parent, courses[1]);
+        }
+    }
+
+    int n = 0;
+    for (int i = 0; i < C; ++i) {
+        component[i] = -1;
+    }
+    for (int i = 0; i < C; ++i) {
+        int root = component_root(parent, i);
+        if (component[root] == -1) component[root] = n++;
+        component[i] = component[root];
+    }
+
+    free(parent);
+    return n;
+}
+
+/*
+ * Compare integers, larger first.
+ */
+int compare_desc(const void *a, const void *b) {
+    int x = *(const int *) a, y = *(const int *) b;
+    return (x < y) - (x > y);
+}
+
+/*
+ * Lower bound of badness points of any individual.
+ * Badness is the penalty of running nothing minus gains of run courses: 20 + students of course,
+ * minus students over capacity, plus 5 points of its prof and 2 points per lab taken by TAs.
+ * Upper bound of gains is the smaller of two relaxations:
+ * at most 2P courses run (the best ones), and TAs of every component give at most 4 labs each
+ * (fractional knapsack with labs as weights). Courses whose TAs cannot cover their labs, or with no profs at all, never run.
+ */
+int lower_bound(int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **tas_pool, const int *c_studs) {
+    int *gain = malloc((C + 1) * sizeof(int));
+    int *sorted = malloc((C + 1) * sizeof(int));
+    int *component = malloc((C + 1) * sizeof(int));
+    long long nothing = 10LL * P + 8LL * T; // badness when no course is run
+    int feasible = 0;
+
+    for (int i = 0; i < C; ++i) {
+        nothing += 20 + c_studs[i];
+        gain[i] = 20 + c_studs[i] - maximum(0, c_studs[i] - courses[i] -> students_number) + 5 + 2 * courses[i] -> labs_number;
+        if (P == 0 || 4 * tas_pool[i][0] < courses[i] -> labs_number) gain[i] = 0;
+        else feasible++;
+        sorted[i] = gain[i];
+    }
+
+    // profs: the best min(2P, feasible) courses
+    int run = feasible < 2 * P ? feasible : 2 * P;
+    qsort(sorted, (size_t) C, sizeof(int), compare_desc);
+    long long profs_bound = 0;
+    for (int k = 0; k < run; ++k) {
+        profs_bound += sorted[k];
+    }
+
+    // TAs: fractional knapsack in every component, courses by gain per lab, the best first
+    int n = find_components(C, P, T, profs, tas, component);
+    int *labs_left = calloc((size_t) n + 1, sizeof(int));
+    for (int t = 0; t < T; ++t) {
+        labs_left[component[tas[t] -> courses[1]]] += 4;
+    }
+    for (int i = 0; i < C; ++i) {
+        sorted[i] = i;
+    }
+    for (int i = 1; i < C; ++i) {
+        for (int j = i; j > 0 && (long long) gain[sorted[j]] * courses[sorted[j - 1]] -> labs_number >
+                                 (long long) gain[sorted[j - 1]] * courses[sorted[j]] -> labs_number; --j) {
+            int tmp = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = tmp;
+        }
+    }
+    long long labs_bound = 0;
+    for (int k = 0; k < C; ++k) {
+        int i = sorted[k], labs = courses[i] -> labs_number;
+        int *left = &labs_left[component[i]];
+        if (gain[i] == 0 || *left == 0) continue;
+
+        if (labs <= *left) {
+            labs_bound += gain[i];
+            *left -= labs;
+        } else {
+            labs_bound += ((long long) gain[i] * *left + labs - 1) / labs;
+            *left = 0;
+        }
+    }
+
+    free(labs_left);
+    free(component);
+    free(sorted);
+    free(gain);
+
+    long long bound = nothing - (profs_bound < labs_bound ? profs_bound : labs_bound);
+    return bound > 0 ? (int) bound : 0;
+}
+
+/*
+ * Share of different genes between the first parents genomes of population, averaged over DIVERSITY_PAIRS pairs.
+ * Pairs are fixed, so measuring does not change the random sequence.
+ */
+double population_diversity(cpop_t *pop, int parents) {
+    const layout_t *layout = pop -> layout;
+    long long distance = 0;
+
+    if (parents < 2 || layout -> genes == 0) return 0;
+    for (int k = 0; k < DIVERSITY_PAIRS; ++k) {
+        int a = k % parents, b = (a + 1 + k * 7) % parents;
+        if (a == b) b = (a + 1) % parents;
+        distance += genome_distance(layout, cpop_genome(pop, a), cpop_genome(pop, b));
+    }
+
+    return (double) distance / DIVERSITY_PAIRS / layout -> genes;
+}
+
+/*
+ * Change mutants and parents of run for the next generation by diversity of parents:
+ * a converged population gets a quarter more of both, a scattered one a fifth less.
+ * Sizes stay between a quarter and four times those of cfg, and fit into population.
+ */
+void adapt_config(config_t *run, const config_t *cfg, double diversity) {
+    int n = run -> population_size;
+    int mutation_size = run -> mutation_size, best_size = run -> best_size;
+
+    if (diversity < DIVERSITY_LOW) {
+        mutation_size += mutation_size / 4 + 1;
+        best_size += best_size / 4 + 1;
+    } else if (diversity > DIVERSITY_HIGH) {
+        mutation_size -= mutation_size / 5;
+        best_size -= best_size / 5;
+    }
+
+    mutation_size = maximum(cfg -> mutation_size / 4, minimum(mutation_size, 4 * cfg -> mutation_size));
+    best_size = maximum(maximum(1, cfg -> best_size / 4), minimum(best_size, 4 * cfg -> best_size));
+    best_size = minimum(best_size, n - run -> kids_size);
+    mutation_size = minimum(mutation_size, n - run -> kids_size - best_size);
+
+    run -> mutation_size = mutation_size;
+    run -> best_size = best_size;
+}
+
+/*
+ * Best solution shared by lanes of portfolio solver.
+ */
+typedef struct portfolio_s {
+    const config_t *cfg;
+    int C;
+    int P;
+    int T;
+    course_t **courses;
+    professor_t **profs;
+    ta_t **tas;
+    int **profs_pool;
+    int **tas_pool;
+    int *c_studs;
+    const layout_t *layout; // layout of genomes of all lanes
+    pthread_mutex_t lock;
+    unsigned char *best; // the best genome offered by lanes
+    int badness; // its badness points, MAX_BADNESS_POINTS - none yet
+    int winner; // lane that offered it, -1 - none
+    int bound; // see lower_bound
+    int reached; // 1 when a lane reached bound
+    double lane_seconds; // CPU seconds of one lane, 0 - unlimited
+} portfolio_t;
+
+/*
+ * One strategy with one seed raced by portfolio solver.
+ */
+typedef struct portfolio_lane_s {
+    portfolio_t *portfolio;
+    int index;
+    int strategy; // see STRATEGY_GENERATIONS
+    int shares; // 1 - lane exchanges genomes with portfolio, 0 - its genomes have other layout, it only stops with lane_over
+    double start; // CPU seconds of thread when lane started
+    stats_t stats;
+} lane_t;
+
+/*
+ * CPU seconds used by calling thread.
+ */
+double thread_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (double) now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * Offer genome with badness points to portfolio of lane. If portfolio has a better genome,
+ * it is copied into genome instead. Returns badness points of genome after that.
+ */
+int lane_share(lane_t *lane, unsigned char *genome, int badness) {
+    portfolio_t *portfolio = lane -> portfolio;
+    size_t size = portfolio -> layout -> size;
+
+    pthread_mutex_lock(&portfolio -> lock);
+    if (badness < portfolio -> badness) {
+        memcpy(portfolio -> best, genome, size);
+        portfolio -> badness = badness;
+        portfolio -> winner = lane -> index;
+        if (badness <= portfolio -> bound) __atomic_store_n(&portfolio -> reached, 1, __ATOMIC_RELAXED);
+    } else if (portfolio -> badness < badness) {
+        memcpy(genome, portfolio -> best, size);
+        badness = portfolio -> badness;
+        stats.shared++;
+    }
+    pthread_mutex_unlock(&portfolio -> lock);
+
+    return badness;
+}
+
+/*
+ * Check if lane must stop: some lane reached the lower bound or lane used its CPU time.
+ */
+int lane_over(const lane_t *lane) {
+    const portfolio_t *portfolio = lane -> portfolio;
+    return __atomic_load_n(&portfolio -> reached, __ATOMIC_RELAXED) ||
+           portfolio -> lane_seconds > 0 && thread_seconds() - lane -> start > portfolio -> lane_seconds;
+}
+
+/*
+ * Find the best individual with genetic algorithm configured by cfg.
+ * Search stops after cfg -> generations_number generations or when time budget is spent in CPU time of calling thread.
+ * If checkpoint is not NULL, state is written there every cfg -> checkpoint_seconds before a generation.
+ * If resume is not NULL, search continues from it exactly as if it had not been stopped.
+ * If stream is not NULL, every improvement of the best individual is written there (see stream_best).
+ * If lane is not NULL, search stops when lane is over; if lane shares genomes, the best one is exchanged
+ * with other lanes of portfolio every generation.
+ */
+ind_t *get_best_sol(const config_t *cfg, int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **profs_pool, int **tas_pool, int *c_studs,
+                    archive_t *archive, const char *checkpoint, const ckpt_t *resume, FILE *stream, lane_t *lane) {
+    double start = thread_seconds(), last_checkpoint = start; // CPU time of this thread, components are searched concurrently
+    double cpu_before = 0; // CPU seconds spent before resume
+    int generation = 0;
+    fcache_t *cache = create_fcache();
+    layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+    cpop_t *pop = create_cpop(layout, cfg -> population_size);
+    scratch_t *scratch = create_scratch(C, P, T, tas_pool);
+    long long allocations = 0; // allocations before generations
+    config_t run = *cfg; // sizes changed by adapt_config
+    int measured = 0; // diversity was measured
+    unsigned long long fingerprint = instance_fingerprint(C, P, T, courses, profs_pool, tas_pool, c_studs);
+    unsigned char *streamed = malloc(layout -> size + 1); // last genome written into stream
+    int streamed_badness = MAX_BADNESS_POINTS;
+    // front keeps every trade-off, so its search is not stopped at the bound of total badness
+    int bound = archive == NULL ? lower_bound(C, P, T, courses, profs, tas, tas_pool, c_studs) : -1;
+    int reached = 0;
+
+    if (resume != NULL) {
+        memcpy(pop -> genomes, resume -> genomes, (size_t) pop -> n * layout -> size);
+        memcpy(pop -> badness, resume -> badness, pop -> n * sizeof(int));
+        memcpy(pop -> hash, resume -> hash, pop -> n * sizeof(unsigned long long));
+        stats_t heap = stats; // memory and hardware counters belong to this process
+        stats = resume -> header.stats;
+        stats.allocations = heap.allocations;
+        stats.live_bytes = heap.live_bytes;
+        stats.peak_bytes = heap.peak_bytes;
+        memcpy(stats.perf, heap.perf, sizeof(stats.perf));
+        stats.perf_missing = heap.perf_missing;
+        rng.state = resume -> header.rng_state;
+        generation = resume -> header.generation;
+        cpu_before = resume -> header.cpu_seconds;
+        stats.resumed = 1;
+        for (int j = 0; j < pop -> n; ++j) {
+            if (pop -> badness[j] <= bound) reached = 1;
+        }
+    }
+
+    stats.genome_bytes = (long long) layout -> size;
+    stats.population_bytes = (long long) cpop_memory(pop);
+
+    if (resume == NULL) {
+        reached = fill_population(cfg, pop, 0, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, scratch, cache, archive, bound);
+        stats.distinct = count_distinct(pop -> n, pop -> hash);
+    }
+    allocations = stats.allocations;
+    if (stream != NULL) stream_best(stream, pop, streamed, &streamed_badness, generation, cpu_before + thread_seconds() - start);
+
+    for (; !reached && generation < cfg -> generations_number; ++generation) {
+        double cpu_seconds = cpu_before + thread_seconds() - start;
+        if (cfg -> time_budget > 0 && cpu_seconds > cfg -> time_budget) break;
+
+        if (checkpoint != NULL && thread_seconds() - last_checkpoint >= cfg -> checkpoint_seconds) {
+            if (write_checkpoint(checkpoint, &run, pop, cache, fingerprint, generation, cpu_seconds)) fprintf(stderr, "Cannot write checkpoint %s\n", checkpoint);
+            last_checkpoint = thread_seconds();
+        }
+
+        choose_best_genomes(pop, run.best_size);
+        if (lane != NULL && lane_over(lane)) break;
+        if (lane != NULL && lane -> shares) {
+            int badness = lane_share(lane, cpop_genome(pop, 0), pop -> badness[0]);
+            if (badness != pop -> badness[0]) {
+                pop -> badness[0] = badness;
+                pop -> hash[0] = genome_hash(layout, cpop_genome(pop, 0));
+            }
+        }
+        int parents = run.best_size;
+        double diversity = population_diversity(pop, parents);
+        stats.diversity = (long long) (1000 * diversity + 0.5);
+        stats.lowest_diversity = !measured || stats.diversity < stats.lowest_diversity ? stats.diversity : stats.lowest_diversity;
+        measured = 1;
+        if (cfg -> adapt) {
+            adapt_config(&run, cfg, diversity);
+            if (run.best_size > parents) choose_best_genomes(pop, run.best_size); // added parents are the next best genomes
+        }
+        stats.mutation_size = run.mutation_size;
+        stats.best_size = run.best_size;
+        reached = fill_population(&run, pop, run.best_size, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, scratch, cache, archive, bound);
+        stats.generations++;
+        if (stream != NULL) stream_best(stream, pop, streamed, &streamed_badness, generation + 1, cpu_before + thread_seconds() - start);
+    }
+    stats.generation_allocations += stats.allocations - allocations;
+    choose_best_genomes(pop, 1);
+    stats.badness = pop -> badness[0];
+    stats.lower_bound = bound;
+    if (pop -> badness[0] <= bound) stats.bound_reached++;
+
+    ind_t *best = decode_ind(layout, cpop_genome(pop, 0), courses, profs, tas);
+    best -> badness_points = pop -> badness[0];
+
+    stats.cache_lookups += cache -> lookups;
+    stats.cache_hits += cache -> hits;
+    free_scratch(scratch);
+    free_fcache(cache);
+    free(streamed);
+    free_cpop(pop);
+    free_layout(layout);
+
+    return best;
+}
+
+/*
+ * Add counters of from to to. All counters are long long.
+ */
+void add_stats(stats_t *to, const stats_t *from) {
+    long long *to_counters = (long long *) to;
+    const long long *from_counters = (const long long *) from;
+
+    for (size_t k = 0; k < sizeof(stats_t) / sizeof(long long); ++k) {
+        to_counters[k] += from_counters[k];
+    }
+}
+
+/*
+ * Population shared by threads of steady-state search.
+ * Genome, hash and badness of member j change only under locks[j & (STEADY_LOCKS - 1)];
+ * tournaments read badness without lock.
+ */
+typedef struct steady_search_s {
+    const config_t *cfg;
+    int P;
+    int T;
+    course_t **courses;
+    professor_t **profs;
+    ta_t **tas;
+    int **profs_pool;
+    int **tas_pool;
+    int *c_studs;
+    cpop_t *pop;
+    pthread_mutex_t locks[STEADY_LOCKS];
+    long long steps; // steps not taken yet, taken by threads STEADY_CHUNK at a time
+    int bound; // see lower_bound
+    int reached; // 1 when a child reached bound
+    double budget; // CPU seconds of every thread for steps, 0 - unlimited
+    lane_t *lane; // lane of portfolio solver or NULL
+} steady_t;
+
+/*
+ * One thread of steady-state search.
+ */
+typedef struct steady_task_s {
+    steady_t *search;
+    int index;
+    int seeded; // 1 - task has own random sequence and stats, 0 - it uses those of calling thread
+    stats_t stats;
+} steady_task_t;
+
+/*
+ * Badness of member j, read without lock.
+ */
+int steady_badness(cpop_t *pop, int j) {
+    return __atomic_load_n(&pop -> badness[j], __ATOMIC_RELAXED);
+}
 
-    professor_t *professor = create_professor(id, name, courses);
+/*
+ * Tournament of size random members: the best one, or the worst one if worst is 1.
+ */
+int steady_tournament(cpop_t *pop, int size, int worst) {
+    int chosen = randInt(0, pop -> n);
 
-    if (addProfToHashTable(phash, professor)) error = 1;
+    for (int k = 1; k < size; ++k) {
+        int j = randInt(0, pop -> n);
+        int a = steady_badness(pop, j), b = steady_badness(pop, chosen);
+        if (worst ? a > b : a < b) chosen = j;
+    }
+
+    return chosen;
+}
+
+/*
+ * Copy genome of tournament winner into genome.
+ */
+void steady_parent(steady_t *search, unsigned char *genome) {
+    cpop_t *pop = search -> pop;
+    int j = steady_tournament(pop, search -> cfg -> tournament_size, 0);
+    pthread_mutex_t *lock = &search -> locks[j & (STEADY_LOCKS - 1)];
+
+    pthread_mutex_lock(lock);
+    memcpy(genome, cpop_genome(pop, j), pop -> layout -> size);
+    pthread_mutex_unlock(lock);
+}
+
+/*
+ * One step of steady-state search: make a child as a generation would (kid of two tournament winners,
+ * mutant of one, or random genome, in shares of config), score it and put it in place of the loser
+ * of a reverse tournament if it is not worse. Genomes a and b are scratch for parents.
+ */
+void steady_step(steady_t *search, scratch_t *scratch, fcache_t *cache, unsigned char *a, unsigned char *b, unsigned char *child) {
+    const config_t *cfg = search -> cfg;
+    cpop_t *pop = search -> pop;
+    const layout_t *layout = pop -> layout;
+    int P = search -> P, T = search -> T;
+    int r = randInt(0, pop -> n - cfg -> best_size);
+
+    if (r < cfg -> kids_size) {
+        steady_parent(search, a);
+        steady_parent(search, b);
+        cross_genomes(layout, a, b, child, P, T, search -> courses, search -> profs, search -> tas, search -> profs_pool, search -> tas_pool, scratch -> work);
+    } else if (r < cfg -> kids_size + cfg -> mutation_size) {
+        steady_parent(search, a);
+        mutate_genome(layout, a, child, P, T, search -> courses, search -> profs, search -> tas, search -> profs_pool, search -> tas_pool, scratch -> work);
+    } else {
+        distr_genome(layout, child, P, T, search -> courses, search -> profs, search -> profs_pool, search -> tas_pool, scratch -> work);
+    }
+
+    unsigned long long hash = genome_hash(layout, child);
+    stats.individuals++;
+    stats.steady_steps++;
+    if (fcache_get(cache, hash) != -1) return; // this thread has seen the child already
+
+    int badness = genome_badness(layout, child, P, T, search -> courses, search -> c_studs, scratch -> work);
+    fcache_put(cache, hash, badness);
+    if (badness == MAX_BADNESS_POINTS) {
+        stats.wasted++;
+        return;
+    }
+
+    int j = steady_tournament(pop, cfg -> tournament_size, 1);
+    pthread_mutex_t *lock = &search -> locks[j & (STEADY_LOCKS - 1)];
+    pthread_mutex_lock(lock);
+    if (badness <= pop -> badness[j] && hash != pop -> hash[j]) {
+        memcpy(cpop_genome(pop, j), child, layout -> size);
+        pop -> hash[j] = hash;
+        __atomic_store_n(&pop -> badness[j], badness, __ATOMIC_RELAXED);
+        stats.replaced++;
+    }
+    pthread_mutex_unlock(lock);
+
+    if (badness <= search -> bound) __atomic_store_n(&search -> reached, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Exchange the best member of population with other lanes of portfolio (see lane_share).
+ */
+void steady_share(steady_t *search) {
+    cpop_t *pop = search -> pop;
+    int j = 0;
+    for (int k = 1; k < pop -> n; ++k) {
+        if (steady_badness(pop, k) < steady_badness(pop, j)) j = k;
+    }
+
+    pthread_mutex_t *lock = &search -> locks[j & (STEADY_LOCKS - 1)];
+    pthread_mutex_lock(lock);
+    int badness = lane_share(search -> lane, cpop_genome(pop, j), pop -> badness[j]);
+    if (badness != pop -> badness[j]) {
+        pop -> hash[j] = genome_hash(pop -> layout, cpop_genome(pop, j));
+        __atomic_store_n(&pop -> badness[j], badness, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(lock);
+}
+
+/*
+ * Task of worker pool: take steps of steady-state search until there are none left,
+ * a child reaches the lower bound or time budget is over.
+ */
+void *steady_task(void *arg) {
+    steady_task_t *task = arg;
+    steady_t *search = task -> search;
+    const layout_t *layout = search -> pop -> layout;
+
+    if (task -> seeded) {
+        rng_seed(&rng, SEED + task -> index);
+        memset(&stats, 0, sizeof(stats));
+    }
+    perf.enabled = search -> cfg -> profile;
+    int outer = perf_phase(PHASE_GENERATION); // tournaments are too short to be counted apart
+
+    scratch_t *scratch = create_scratch(layout -> C, search -> P, search -> T, search -> tas_pool);
+    fcache_t *cache = create_fcache();
+    unsigned char *genomes = track_malloc(3 * layout -> size + 1); // two parents and child
+    double start = thread_seconds();
+
+    while (!__atomic_load_n(&search -> reached, __ATOMIC_RELAXED)) {
+        long long left = __atomic_fetch_sub(&search -> steps, STEADY_CHUNK, __ATOMIC_RELAXED);
+        if (left <= 0) break;
+        if (search -> budget > 0 && thread_seconds() - start > search -> budget) break;
+        if (search -> lane != NULL) {
+            if (lane_over(search -> lane)) break;
+            if (search -> lane -> shares) steady_share(search);
+        }
+
+        for (long long s = 0; s < left && s < STEADY_CHUNK && !__atomic_load_n(&search -> reached, __ATOMIC_RELAXED); ++s) {
+            steady_step(search, scratch, cache, genomes, genomes + layout -> size, genomes + 2 * layout -> size);
+        }
+    }
+
+    stats.cache_lookups += cache -> lookups;
+    stats.cache_hits += cache -> hits;
+    track_free(genomes);
+    free_fcache(cache);
+    free_scratch(scratch);
+
+    perf_phase(outer);
+    if (outer == -1) perf_close();
+    if (task -> seeded) task -> stats = stats;
+    return NULL;
+}
+
+/*
+ * Find the best individual with steady-state genetic algorithm.
+ * Population zero is made as by get_best_sol; then every step makes one child (see steady_step),
+ * as many as generations of cfg would make. Steps are taken by all threads of pool
+ * (if pool is NULL, only by calling thread), which insert children into one shared population.
+ * Time budget is counted in CPU time of every thread. With more than one thread the result depends on their timing.
+ * If lane is not NULL, steps stop when lane is over; if lane shares genomes, the best member is exchanged
+ * with other lanes of portfolio every STEADY_CHUNK steps.
+ */
+ind_t *get_steady_sol(const config_t *cfg, pool_t *pool, int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas,
+                      int **profs_pool, int **tas_pool, int *c_studs, lane_t *lane) {
+    layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+    cpop_t *pop = create_cpop(layout, cfg -> population_size);
+    scratch_t *scratch = create_scratch(C, P, T, tas_pool);
+    fcache_t *cache = create_fcache();
+    steady_t search = {
+            .cfg = cfg, .P = P, .T = T, .courses = courses, .profs = profs, .tas = tas,
+            .profs_pool = profs_pool, .tas_pool = tas_pool, .c_studs = c_studs, .pop = pop,
+            .steps = (long long) cfg -> generations_number * (pop -> n - cfg -> best_size),
+            .bound = lower_bound(C, P, T, courses, profs, tas, tas_pool, c_studs), .reached = 0, .budget = 0, .lane = lane
+    };
+    double start = thread_seconds();
+
+    stats.genome_bytes = (long long) layout -> size;
+    stats.population_bytes = (long long) cpop_memory(pop);
+    search.reached = fill_population(cfg, pop, 0, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, scratch, cache, NULL, search.bound);
+    stats.distinct = count_distinct(pop -> n, pop -> hash);
+    stats.cache_lookups += cache -> lookups;
+    stats.cache_hits += cache -> hits;
+    free_fcache(cache);
+    free_scratch(scratch);
+
+    // threads take steps concurrently, each within what is left of the budget after population zero
+    if (cfg -> time_budget > 0) {
+        search.budget = cfg -> time_budget - (thread_seconds() - start);
+        if (search.budget <= 0) search.steps = 0;
+    }
+
+    int threads = pool != NULL ? pool -> workers + 1 : 1;
+    if (!search.reached && search.steps > 0) {
+        for (int k = 0; k < STEADY_LOCKS; ++k) {
+            pthread_mutex_init(&search.locks[k], NULL);
+        }
+
+        steady_task_t *tasks = malloc(threads * sizeof(steady_task_t));
+        for (int t = 0; t < threads; ++t) {
+            tasks[t] = (steady_task_t) {.search = &search, .index = t, .seeded = threads > 1};
+        }
+        if (threads == 1) {
+            steady_task(&tasks[0]);
+        } else {
+            stats_t saved_stats = stats; // calling thread takes steps too
+            rng_t saved_rng = rng;
+            pool_run(pool, threads, steady_task, tasks, sizeof(steady_task_t));
+            stats = saved_stats;
+            rng = saved_rng;
+            for (int t = 0; t < threads; ++t) {
+                add_stats(&stats, &tasks[t].stats);
+            }
+        }
+        free(tasks);
+
+        for (int k = 0; k < STEADY_LOCKS; ++k) {
+            pthread_mutex_destroy(&search.locks[k]);
+        }
+    }
+
+    choose_best_genomes(pop, 1);
+    stats.badness = pop -> badness[0];
+    stats.lower_bound = search.bound;
+    if (pop -> badness[0] <= search.bound) stats.bound_reached++;
+
+    ind_t *best = decode_ind(layout, cpop_genome(pop, 0), courses, profs, tas);
+    best -> badness_points = pop -> badness[0];
+
+    free_cpop(pop);
+    free_layout(layout);
+    return best;
+}
+
+/*
+ * State of exact branch and bound solver.
+ *
+ * Badness of a possible individual is 10 * P + 8 * T plus, for every course,
+ * 20 + demand if it is not run, or overflow - 5 - 2 * labs if it is run.
+ * So it depends only on the set of run courses, and the search branches on
+ * whether each course is run and by which prof. TAs matter only for feasibility,
+ * which is kept by an incremental max flow from courses to TAs.
+ */
+typedef struct exact_solver_s {
+    int C;
+    int P;
+    int T;
+    course_t **courses;
+    professor_t **profs;
+    int **profs_pool;
+    int **tas_pool;
+    int *order; // courses sorted by gain, the best first
+    int *pos; // pos[i] = position of course i in order
+    int *ratio_order; // courses sorted by gain per lab, the best first
+    int *gain; // gain[i] = how much badness decreases when course i is run
+    int *rest; // rest[k] = sum of gains of order[k..C-1]
+    int *prof_load; // 2 - prof cannot take more courses
+    int *prof_of; // prof of course in current branch or -1
+    int *best_prof_of; // prof of course in best found individual or -1
+    int *flow; // flow[i * T + t] = labs of course i given to TA t
+    int *ta_load;
+    int *saved_flow; // saved_flow[k * C * T ..] = flow before branching on position k
+    int *saved_load; // saved_load[k * T ..] = ta_load before branching on position k
+    int *visited;
+    int free_slots; // courses that profs can still take
+    int free_labs; // labs that TAs can still take
+    int cur_gain;
+    int best_gain;
+    long long nodes;
+} exact_t;
+
+/*
+ * Upper bound of gain of courses from position k on, given free labs of TAs:
+ * fractional knapsack with labs as weights.
+ */
+int exact_labs_bound(exact_t *ex, int k) {
+    int labs_left = ex -> free_labs;
+    int bound = 0;
+
+    for (int j = 0; j < ex -> C && labs_left > 0; ++j) {
+        int c = ex -> ratio_order[j];
+        int labs = ex -> courses[c] -> labs_number;
+        if (ex -> pos[c] < k) continue;
+
+        if (labs <= labs_left) {
+            bound += ex -> gain[c];
+            labs_left -= labs;
+        } else {
+            bound += (ex -> gain[c] * labs_left + labs - 1) / labs;
+            labs_left = 0;
+        }
+    }
+
+    return bound;
+}
+
+/*
+ * Check whether prof p is trained for some course that is branched on after position k.
+ * Profs without such courses and with the same load are interchangeable for the rest of the search.
+ */
+int exact_prof_has_future(exact_t *ex, int p, int k) {
+    for (int j = 1; j < ex -> profs[p] -> courses[0] + 1; ++j) {
+        if (ex -> pos[ex -> profs[p] -> courses[j]] > k) return 1;
+    }
+    return 0;
+}
+
+/*
+ * Find one more lab for course c with augmenting path over TAs.
+ */
+int exact_augment(exact_t *ex, int c) {
+    for (int k = 1; k < ex -> tas_pool[c][0] + 1; ++k) {
+        int t = ex -> tas_pool[c][k];
+        if (ex -> visited[t]) continue;
+        ex -> visited[t] = 1;
+
+        if (ex -> ta_load[t] < 4) {
+            ex -> flow[c * ex -> T + t]++;
+            ex -> ta_load[t]++;
+            return 1;
+        }
+
+        // TA is full: try to move one of their labs of another course to a different TA
+        for (int c2 = 0; c2 < ex -> C; ++c2) {
+            if (c2 != c && ex -> flow[c2 * ex -> T + t] > 0 && exact_augment(ex, c2)) {
+                ex -> flow[c2 * ex -> T + t]--;
+                ex -> flow[c * ex -> T + t]++;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Give all labs of course c to TAs. If it is impossible, flow is left changed
+ * and must be restored by the caller.
+ */
+int exact_add_labs(exact_t *ex, int c) {
+    for (int lab = 0; lab < ex -> courses[c] -> labs_number; ++lab) {
+        memset(ex -> visited, 0, ex -> T * sizeof(int));
+        if (!exact_augment(ex, c)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Branch on course order[k]: run it with one of possible profs or do not run it.
+ */
+void exact_search(exact_t *ex, int k) {
+    ex -> nodes++;
+
+    if (ex -> cur_gain > ex -> best_gain) {
+        ex -> best_gain = ex -> cur_gain;
+        memcpy(ex -> best_prof_of, ex -> prof_of, ex -> C * sizeof(int));
+    }
+    if (k == ex -> C) return;
+
+    // at most free_slots of the remaining courses can be run, the best of them are first in order
+    int end = k + ex -> free_slots < ex -> C ? k + ex -> free_slots : ex -> C;
+    if (ex -> cur_gain + ex -> rest[k] - ex -> rest[end] <= ex -> best_gain) return;
+    if (ex -> cur_gain + exact_labs_bound(ex, k) <= ex -> best_gain) return;
+
+    int c = ex -> order[k];
+    if (ex -> gain[c] == 0) {
+        exact_search(ex, k + 1);
+        return;
+    }
+
+    int *saved_flow = ex -> saved_flow + (size_t) k * ex -> C * ex -> T;
+    int *saved_load = ex -> saved_load + (size_t) k * ex -> T;
+    memcpy(saved_flow, ex -> flow, (size_t) ex -> C * ex -> T * sizeof(int));
+    memcpy(saved_load, ex -> ta_load, ex -> T * sizeof(int));
+
+    if (exact_add_labs(ex, c)) {
+        int tried = 0; // bit mask of tried (trained, load) pairs among profs without future courses
+        ex -> free_labs -= ex -> courses[c] -> labs_number;
+        for (int p = 0; p < ex -> P; ++p) {
+            int trained = is_in_courses(p, ex -> profs_pool[c]);
+            if (ex -> prof_load[p] == 2 || (!trained && ex -> prof_load[p] != 0)) continue;
+            if (!exact_prof_has_future(ex, p, k)) {
+                int key = 1 << (2 * trained + ex -> prof_load[p]);
+                if (tried & key) continue;
+                tried |= key;
+            }
+
+            int old_load = ex -> prof_load[p];
+            ex -> prof_load[p] = trained ? old_load + 1 : 2;
+            ex -> free_slots -= ex -> prof_load[p] - old_load;
+            ex -> prof_of[c] = p;
+            ex -> cur_gain += ex -> gain[c];
+
+            exact_search(ex, k + 1);
+
+            ex -> cur_gain -= ex -> gain[c];
+            ex -> prof_of[c] = -1;
+            ex -> free_slots += ex -> prof_load[p] - old_load;
+            ex -> prof_load[p] = old_load;
+        }
+        ex -> free_labs += ex -> courses[c] -> labs_number;
+    }
+
+    memcpy(ex -> flow, saved_flow, (size_t) ex -> C * ex -> T * sizeof(int));
+    memcpy(ex -> ta_load, saved_load, ex -> T * sizeof(int));
+
+    exact_search(ex, k + 1);
+}
+
+/*
+ * Find individual with the least possible badness by branch and bound.
+ * Meant for small instances only: the search is exponential in C.
+ * If nodes is not NULL, the number of visited nodes is put there.
+ */
+ind_t *get_exact_sol(int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **profs_pool, int **tas_pool, int *c_studs, long long *nodes) {
+    exact_t ex;
+
+    ex.C = C;
+    ex.P = P;
+    ex.T = T;
+    ex.courses = courses;
+    ex.profs = profs;
+    ex.profs_pool = profs_pool;
+    ex.tas_pool = tas_pool;
+    ex.order = malloc(C * sizeof(int));
+    ex.pos = malloc(C * sizeof(int));
+    ex.ratio_order = malloc(C * sizeof(int));
+    ex.gain = malloc(C * sizeof(int));
+    ex.rest = malloc((C + 1) * sizeof(int));
+    ex.prof_load = calloc((size_t) P, sizeof(int));
+    ex.prof_of = malloc(C * sizeof(int));
+    ex.best_prof_of = malloc(C * sizeof(int));
+    ex.flow = calloc((size_t) C * T, sizeof(int));
+    ex.ta_load = calloc((size_t) T, sizeof(int));
+    ex.saved_flow = malloc((size_t) C * C * T * sizeof(int));
+    ex.saved_load = malloc((size_t) C * T * sizeof(int));
+    ex.visited = malloc((T + 1) * sizeof(int));
+    ex.free_slots = 2 * P;
+    ex.free_labs = 4 * T;
+    ex.cur_gain = 0;
+    ex.best_gain = 0;
+    ex.nodes = 0;
+
+    for (int i = 0; i < C; ++i) {
+        ex.gain[i] = 20 + c_studs[i] - maximum(0, c_studs[i] - courses[i] -> students_number) + 5 + 2 * courses[i] -> labs_number;
+        if (4 * tas_pool[i][0] < courses[i] -> labs_number) ex.gain[i] = 0; // never can be run, does not count in bounds
+        ex.order[i] = i;
+        ex.ratio_order[i] = i;
+        ex.prof_of[i] = -1;
+        ex.best_prof_of[i] = -1;
+    }
+
+    // insertion sorts by gain and by gain per lab, instances are small
+    for (int i = 1; i < C; ++i) {
+        for (int j = i; j > 0 && ex.gain[ex.order[j]] > ex.gain[ex.order[j - 1]]; --j) {
+            int tmp = ex.order[j];
+            ex.order[j] = ex.order[j - 1];
+            ex.order[j - 1] = tmp;
+        }
+        for (int j = i; j > 0 && ex.gain[ex.ratio_order[j]] * courses[ex.ratio_order[j - 1]] -> labs_number >
+                                 ex.gain[ex.ratio_order[j - 1]] * courses[ex.ratio_order[j]] -> labs_number; --j) {
+            int tmp = ex.ratio_order[j];
+            ex.ratio_order[j] = ex.ratio_order[j - 1];
+            ex.ratio_order[j - 1] = tmp;
+        }
+    }
+
+    ex.rest[C] = 0;
+    for (int k = C - 1; k >= 0; --k) {
+        ex.rest[k] = ex.rest[k + 1] + ex.gain[ex.order[k]];
+        ex.pos[ex.order[k]] = k;
+    }
+
+    exact_search(&ex, 0);
+
+    // rebuild TA assignment of the best set of courses
+    memset(ex.flow, 0, (size_t) C * T * sizeof(int));
+    memset(ex.ta_load, 0, T * sizeof(int));
+
+    ind_t *ind = new_ind(C, courses);
+    for (int i = 0; i < C; ++i) {
+        if (ex.best_prof_of[i] != -1) exact_add_labs(&ex, i);
+    }
+
+    for (int i = 0; i < C; ++i) {
+        if (ex.best_prof_of[i] == -1) continue;
+
+        ind -> cinds[i] -> prof = profs[ex.best_prof_of[i]];
+        ind -> cinds[i] -> runnable = 1;
+        ind -> cinds[i] -> tas = track_malloc(maximum(1, courses[i] -> labs_number) * sizeof(ta_c_t*)); // free here
+        for (int t = 0; t < T; ++t) {
+            if (ex.flow[i * T + t] > 0) add_ta_to_cind(ind -> cinds[i], tas[t], ex.flow[i * T + t]);
+        }
+    }
+
+    calculate_badness(C, P, T, ind, c_studs);
+    ind -> hash = ind_hash(C, ind);
+    if (nodes != NULL) *nodes = ex.nodes;
+
+    free(ex.order);
+    free(ex.pos);
+    free(ex.ratio_order);
+    free(ex.gain);
+    free(ex.rest);
+    free(ex.prof_load);
+    free(ex.prof_of);
+    free(ex.best_prof_of);
+    free(ex.flow);
+    free(ex.ta_load);
+    free(ex.saved_flow);
+    free(ex.saved_load);
+    free(ex.visited);
+
+    return ind;
+}
+
+/*
+ * Students seated in runnable courses of an individual, stored course by course:
+ * seated[offsets[i]] .. seated[offsets[i + 1] - 1] are ids of students of course i.
+ */
+typedef struct seats_s {
+    int *offsets;
+    int *seated;
+} seats_t;
+
+/*
+ * Seat students into runnable courses of individual.
+ * A student may attend all of their courses, so courses do not compete for students and
+ * the allocation is a set of independent problems, one per course. Giving every course
+ * min(demand, capacity) students is therefore a maximum matching; students are taken
+ * in input order. The overflow term of calculate_badness is exactly what is left unseated.
+ * Runs in one pass over all enrollments.
+ */
+seats_t *allocate_seats(int C, const roster_t *roster, ind_t *ind) {
+    seats_t *seats = malloc(sizeof(seats_t));
+    int *last = malloc(C * sizeof(int)); // last seated student of course, used to skip repeated courses
+    int *free_places = malloc(C * sizeof(int));
+
+    seats -> offsets = malloc((C + 1) * sizeof(int));
+    seats -> offsets[0] = 0;
+    for (int i = 0; i < C; ++i) {
+        free_places[i] = ind -> cinds[i] -> runnable ? ind -> cinds[i] -> course -> students_number : 0;
+        seats -> offsets[i + 1] = seats -> offsets[i] + free_places[i];
+        last[i] = -1;
+    }
+
+    int *fill = malloc(C * sizeof(int)); // next free position of course in seated
+    memcpy(fill, seats -> offsets, C * sizeof(int));
+    seats -> seated = malloc((seats -> offsets[C] + 1) * sizeof(int));
+
+    for (int i = 0; i < roster -> S; ++i) {
+        const int *courses = roster_courses(roster, i);
+        for (int j = 0; j < roster -> count[i]; ++j) {
+            int course = courses[j];
+            if (free_places[course] == 0 || last[course] == i) continue;
+
+            seats -> seated[fill[course]++] = i;
+            free_places[course]--;
+            last[course] = i;
+        }
+    }
+
+    // shrink every course to the number of seated students
+    int size = 0;
+    for (int i = 0; i < C; ++i) {
+        int start = seats -> offsets[i];
+        seats -> offsets[i] = size;
+        for (int k = start; k < fill[i]; ++k) {
+            seats -> seated[size++] = seats -> seated[k];
+        }
+    }
+    seats -> offsets[C] = size;
+
+    free(fill);
+    free(free_places);
+    free(last);
+    return seats;
+}
+
+/*
+ * Free space that was used by seats.
+ */
+void free_seats(seats_t *seats) {
+    free(seats -> offsets);
+    free(seats -> seated);
+    free(seats);
+}
+
+/*
+ * Print final version to existing output file.
+ */
+void format_ind(int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, const roster_t *roster, ind_t *ind, FILE *out) {
+    if (out == NULL) return;
+
+    int *courses_places = malloc(C * sizeof(int)); // how many places exist for each course
+    int *profs_flags = malloc(P * sizeof(int)); // flags for professors
+    int *profs_un_c = malloc(P * sizeof(int)); // used for storing untrained course
+    memset(profs_flags, 0, P * sizeof(int));
+    memset(profs_un_c, 0, P * sizeof(int));
+
+    int *tas_busy = malloc(T * sizeof(int)); // how busy tas are
+    memset(tas_busy, 0, T * sizeof(int));
+
+    seats_t *seats = allocate_seats(C, roster, ind);
+
+    for (int i = 0; i < C; ++i) {
+        if (ind -> cinds[i] -> runnable) {
+            courses_places[i] = ind -> cinds[i] -> course -> students_number;
+
+            fprintf(out, "%s\n%s\n", ind -> cinds[i] -> course -> name, ind -> cinds[i] -> prof -> name);
+            if (!prof_has_course(ind -> cinds[i] -> prof, ind -> cinds[i] -> course)) { // if course is untrained
+                profs_flags[ind -> cinds[i] -> prof -> id] = UNTRAINED_COURSE;
+                profs_un_c[ind -> cinds[i] -> prof -> id] = ind -> cinds[i] -> course -> id;
+            } else {
+
+                if (profs_flags[ind -> cinds[i] -> prof -> id] == UNDEFINED) { // if 0 courses
+                    profs_flags[ind -> cinds[i] -> prof -> id] = LACKING_COURSE; // then lacking
+                }
+                else if (profs_flags[ind -> cinds[i] -> prof -> id] == LACKING_COURSE)
+                    profs_flags[ind -> cinds[i] -> prof -> id] = TWO_COURSES; // 2 courses, no problems
+
+            }
+
+            for (int j = 0; j < ind -> cinds[i] -> ta_number; ++j) {
+                tas_busy[ind -> cinds[i] -> tas[j] -> ta -> id] += ind -> cinds[i] -> tas[j] -> number;
+                for (int k = 0; k < ind -> cinds[i] -> tas[j] -> number; ++k) {
+                    fprintf(out, "%s\n", ind -> cinds[i] -> tas[j] -> ta -> name);
+                }
+            }
+
+            for (int k = seats -> offsets[i]; k < seats -> offsets[i + 1]; ++k) {
+                fprintf(out, "%s %s\n", roster_name(roster, seats -> seated[k]), roster_code(roster, seats -> seated[k]));
+            }
+
+            fprintf(out, "\n");
+        } else {
+            courses_places[i] = -1;
+        }
+    }
+
+    for (int i = 0; i < C; ++i) {
+        if (courses_places[i] == -1) {
+            fprintf(out, "%s cannot be run.\n", courses[i] -> name);
+            courses_places[i] = 0;
+        }
+    }
+
+    for (int i = 0; i < P; ++i) {
+        if (profs_flags[i] == UNDEFINED) {
+            fprintf(out, "%s is unassigned.\n", profs[i] -> name);
+        }
+    }
+
+    for (int i = 0; i < P; ++i) {
+        if (profs_flags[i] == UNTRAINED_COURSE) {
+            fprintf(out, "%s is not trained for %s.\n", profs[i] -> name, courses[profs_un_c[i]]->name);
+        } else if (profs_flags[i] == LACKING_COURSE) {
+            fprintf(out, "%s is lacking class.\n", profs[i] -> name);
+        }
+    }
+
+    for (int i = 0; i < T; ++i) {
+        if (4 - tas_busy[i] > 0) {
+            fprintf(out, "%s is lacking %d lab(s).\n", tas[i] -> name, 4 - tas_busy[i]);
+        }
+    }
+
+    for (int i = 0; i < roster -> S; ++i) {
+        const int *studied = roster_courses(roster, i);
+        for (int j = 0; j < roster -> count[i]; ++j) {
+            if (courses_places[studied[j]] == 0) {
+                fprintf(out, "%s is lacking %s.\n", roster_name(roster, i), courses[studied[j]] -> name);
+            } else {
+                courses_places[studied[j]]--;
+            }
+        }
+    }
+    fprintf(out, "Total score is %d.", ind -> badness_points);
+
+
+    // free everything
+    free(courses_places);
+    free(profs_flags);
+    free(profs_un_c);
+    free(tas_busy);
+    free_seats(seats);
+}
+
+/*
+ * Set default values of configuration.
+ */
+void default_config(config_t *cfg) {
+    cfg -> population_size = POPULATION_SIZE;
+    cfg -> best_size = BEST_SIZE;
+    cfg -> kids_size = KIDS_SIZE;
+    cfg -> mutation_size = MUTATION_SIZE;
+    cfg -> generations_number = GENERATIONS_NUMBER;
+    cfg -> time_budget = 0;
+    cfg -> auto_tune = 0;
+    cfg -> print_stats = 0;
+    cfg -> write_front = 0;
+    cfg -> checkpoint_seconds = 0;
+    cfg -> resume = 0;
+    cfg -> write_stream = 0;
+    cfg -> threads = 0;
+    cfg -> delta = 0;
+    cfg -> delta_rounds = DELTA_ROUNDS;
+    cfg -> split = 1;
+    cfg -> steady = 0;
+    cfg -> tournament_size = TOURNAMENT_SIZE;
+    cfg -> adapt = 1;
+    cfg -> greedy_percent = GREEDY_PERCENT;
+    cfg -> profile = 0;
+    cfg -> portfolio = 0;
+}
 
+/*
+ * Check that sizes of configuration fit together. If they do: 0; otherwise: 1
+ */
+int check_config(const config_t *cfg) {
+    return cfg -> population_size < 1 || cfg -> best_size < 1 || cfg -> kids_size < 0 || cfg -> mutation_size < 0 ||
+           cfg -> generations_number < 0 || cfg -> time_budget < 0 || cfg -> checkpoint_seconds < 0 || cfg -> threads < 0 || cfg -> delta_rounds < 0 ||
+           cfg -> tournament_size < 1 || cfg -> greedy_percent < 0 || cfg -> greedy_percent > 100 ||
+           cfg -> best_size + cfg -> kids_size + cfg -> mutation_size > cfg -> population_size;
+}
 
-    if (courses[0] == 0 || state != P_COURSES || error) {
-        free(name);
-        free(courses);
-        free(professor);
-        return NULL;
+/*
+ * Read configuration from command line arguments of form --name=value or --flag.
+ * If any error -> return 1.
+ */
+int parse_config(config_t *cfg, int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        char *arg = argv[i];
+        char *value = strchr(arg, '=');
+        value = value != NULL ? value + 1 : "";
+
+        if (!strncmp(arg, "--population=", 13)) cfg -> population_size = atoi(value);
+        else if (!strncmp(arg, "--best=", 7)) cfg -> best_size = atoi(value);
+        else if (!strncmp(arg, "--kids=", 7)) cfg -> kids_size = atoi(value);
+        else if (!strncmp(arg, "--mutation=", 11)) cfg -> mutation_size = atoi(value);
+        else if (!strncmp(arg, "--generations=", 14)) cfg -> generations_number = atoi(value);
+        else if (!strncmp(arg, "--time-budget=", 14)) cfg -> time_budget = atof(value);
+        else if (!strcmp(arg, "--auto")) cfg -> auto_tune = 1;
+        else if (!strcmp(arg, "--stats")) cfg -> print_stats = 1;
+        else if (!strcmp(arg, "--front")) cfg -> write_front = 1;
+        else if (!strncmp(arg, "--checkpoint=", 13)) cfg -> checkpoint_seconds = atof(value);
+        else if (!strcmp(arg, "--resume")) cfg -> resume = 1;
+        else if (!strcmp(arg, "--stream")) cfg -> write_stream = 1;
+        else if (!strncmp(arg, "--threads=", 10)) cfg -> threads = atoi(value);
+        else if (!strcmp(arg, "--delta")) cfg -> delta = 1;
+        else if (!strncmp(arg, "--delta-rounds=", 15)) cfg -> delta_rounds = atoi(value);
+        else if (!strcmp(arg, "--no-split")) cfg -> split = 0;
+        else if (!strcmp(arg, "--steady")) cfg -> steady = 1;
+        else if (!strncmp(arg, "--tournament=", 13)) cfg -> tournament_size = atoi(value);
+        else if (!strcmp(arg, "--no-adapt")) cfg -> adapt = 0;
+        else if (!strncmp(arg, "--greedy=", 9)) cfg -> greedy_percent = atoi(value);
+        else if (!strcmp(arg, "--profile")) cfg -> profile = 1;
+        else if (!strcmp(arg, "--portfolio")) cfg -> portfolio = 1;
+        else return 1;
     }
 
-    return professor;
+    return check_config(cfg);
 }
 
 /*
- * Get TA from string.
+ * Print command line options into file.
  */
-ta_t *get_t_line(int id, char *line, chash_t *chash, thash_t *thash) {
-    int statesShifts[] = {P_SURNAME, P_COURSES, P_COURSES};
+void print_usage(FILE *file) {
+    fprintf(file, "Options:\n"
+                  "  --population=N    individuals in population (default %d)\n"
+                  "  --best=N          individuals that survive a generation (default %d)\n"
+                  "  --kids=N          children in a generation (default %d)\n"
+                  "  --mutation=N      mutants in a generation (default %d)\n"
+                  "  --generations=N   generations after population zero (default %d)\n"
+                  "  --time-budget=SEC CPU seconds for one input, 0 - unlimited (default 0)\n"
+                  "  --auto            choose sizes from instance and time budget\n"
+                  "  --stats           print solver counters into standard error\n"
+                  "  --front           write Pareto front into ArtemBahanovFront<i>.txt\n"
+                  "  --checkpoint=SEC  save search into ArtemBahanovCheckpoint<i>.bin every SEC CPU seconds\n"
+                  "  --resume          continue from ArtemBahanovCheckpoint<i>.bin if it exists\n"
+                  "  --stream          write every improvement into ArtemBahanovStream<i>.txt (can be a named pipe)\n"
+                  "  --threads=N       threads for parallel parts, 0 - number of processors (default 0)\n"
+                  "  --delta           apply change lists input<i>.delta<k>.txt to students of input<i>.txt,\n"
+                  "                    writing ArtemBahanovOutput<i>.delta<k>.txt\n"
+                  "  --delta-rounds=N  rounds of local search after change list (default %d)\n"
+                  "  --no-split        do not solve independent groups of courses separately\n"
+                  "  --steady          steady-state search: every step replaces one member by a child\n"
+                  "                    of tournament winners, with as many children as generations would make\n"
+                  "  --tournament=N    members compared by one tournament of steady-state search (default %d)\n"
+                  "  --no-adapt        keep mutants and parents of generations fixed instead of following diversity\n"
+                  "  --greedy=PERCENT  percent of population zero built greedily, courses in demand first (default %d)\n"
+                  "  --profile         print cycles, instructions, cache and branch misses of solver phases of every input\n"
+                  "                    into standard error (Linux hardware counters)\n"
+                  "  --portfolio       race generations, steady-state, local search and components with different seeds\n"
+                  "                    on all threads, sharing the best solution; the winner is printed into standard error\n",
+            POPULATION_SIZE, BEST_SIZE, KIDS_SIZE, MUTATION_SIZE, GENERATIONS_NUMBER, DELTA_ROUNDS, TOURNAMENT_SIZE, GREEDY_PERCENT);
+}
 
-    char *name = malloc(BUFFER_SIZE);
-    char *surname = name;
-    int *courses = malloc(sizeof(int) * (MAX_COURSES + 1));
-    courses[0] = 0; // 0-th <- number of courses
+/*
+ * Choose population size and number of generations for the instance.
+ * Cost of one individual is measured on PROBE_SIZE random individuals, then the time budget
+ * without time reserved for output is split into generations. An instance with C courses,
+ * P profs and T TAs gets at most 50 * (C + P + T) individuals and C + P + T generations,
+ * so small instances finish almost at once.
+ */
+void auto_tune_config(config_t *cfg, int C, int P, int T, int S, course_t **courses, professor_t **profs, int **profs_pool, int **tas_pool, int *c_studs) {
+    clock_t start = clock();
+    layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+    work_t *work = create_work(C, P, T, tas_pool);
+    soa_t *soa = create_soa(PROBE_SIZE, C, P, T);
+    unsigned char *genome = malloc(layout -> size + 1);
+
+    soa_clear(soa);
+    for (int i = 0; i < PROBE_SIZE; ++i) {
+        distr_genome(layout, genome, P, T, courses, profs, profs_pool, tas_pool, work);
+        genome_hash(layout, genome);
+        soa_store_genome(soa, i, layout, genome);
+    }
+    calculate_badness_batch(soa, courses, c_studs);
+
+    free(genome);
+    free_soa(soa);
+    free_work(work);
+    free_layout(layout);
+    double probe_time = (double) (clock() - start) / CLOCKS_PER_SEC;
+    double ind_time = probe_time / PROBE_SIZE > 1e-9 ? probe_time / PROBE_SIZE : 1e-9;
+
+    double budget = cfg -> time_budget > 0 ? cfg -> time_budget : DEFAULT_TIME_BUDGET;
+    budget -= probe_time + S * OUTPUT_SECONDS_PER_STUDENT;
+
+    double affordable = budget > 0 ? budget / ind_time : 0;
+    int size = C + P + T;
+
+    double population = affordable < 50.0 * size ? affordable : 50.0 * size;
+    if (population < MIN_POPULATION_SIZE) population = MIN_POPULATION_SIZE;
+    if (population > MAX_POPULATION_SIZE) population = MAX_POPULATION_SIZE;
+
+    double generations = affordable / population - 1;
+    if (generations > size) generations = size;
+    if (generations > MAX_GENERATIONS_NUMBER) generations = MAX_GENERATIONS_NUMBER;
+    if (generations < 0) generations = 0;
+
+    cfg -> population_size = (int) population;
+    cfg -> generations_number = (int) generations;
+    cfg -> best_size = maximum(2, (int) ((long long) cfg -> population_size * BEST_SIZE / POPULATION_SIZE));
+    cfg -> kids_size = (int) ((long long) cfg -> population_size * KIDS_SIZE / POPULATION_SIZE);
+    cfg -> mutation_size = (int) ((long long) cfg -> population_size * MUTATION_SIZE / POPULATION_SIZE);
+    if (cfg -> time_budget == 0) cfg -> time_budget = budget > 0 ? budget : 0;
+
+    if (cfg -> print_stats) {
+        fprintf(stderr, "auto-tune: %.3f us per individual, population %d, generations %d, best %d, kids %d, mutation %d\n",
+                1e6 * ind_time, cfg -> population_size, cfg -> generations_number, cfg -> best_size, cfg -> kids_size, cfg -> mutation_size);
+    }
+}
 
-    int state = P_NAME;
-    char *buffer = malloc(BUFFER_SIZE);
-    int error = 0, last_token = 0;
-    struct flag_s *flag = malloc(sizeof(struct flag_s));
-    clearFlag(flag);
+/*
+ * Make array of pointers with size elements able to store one more element.
+ * Capacity is doubled when the array is full.
+ */
+void *reserve_ptrs(void *arr, int size, int *capacity) {
+    if (size < *capacity) return arr;
 
-    while (!last_token) {
-        line = nextToken(buffer, BUFFER_SIZE, line, flag);
-        if (state == P_NAME) {
-            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
-                error = 1;
-                break;
-            }
-            strcpy(name, buffer);
-            name[flag -> length] = ' ';
-            surname = name + flag -> length + 1;
-        } else if (state == P_SURNAME) {
-            if (flag -> contains_digits || flag -> contains_invalid_symbs) {
-                error = 1;
-                break;
-            }
-            strcpy(surname, buffer);
-        } else if (state == P_COURSES) {
-            int courseId;
-            if (flag -> contains_digits || flag -> contains_invalid_symbs || (courseId = getCourseIdFromHashTable(chash, buffer)) == -1) {
-                error = 1;
-                break;
-            }
+    *capacity *= 2;
+    return realloc(arr, (size_t) *capacity * sizeof(void *));
+}
 
-            courses[++courses[0]] = courseId;
-        }
+/*
+ * Print error in existing output file.
+ */
+void print_error(FILE *file) {
+    fprintf(file, "Invalid input.");
+}
 
-        last_token = flag -> last_token;
-        clearFlag(flag);
-        state = statesShifts[state];
+/*
+ * Instance kept by solver after valid input together with its solution, so change lists of students can be applied to it.
+ */
+typedef struct problem_s {
+    int C, P, T;
+    course_t **courses;
+    professor_t **profs;
+    ta_t **tas;
+    roster_t *roster;
+    int **profs_pool;
+    int **tas_pool;
+    int *c_studs;
+    layout_t *layout;
+    unsigned char *best; // genome of solution
+    int *code_ids; // code_ids[k] = id of student with code hashed to k, -1 - free; built on first change list
+    int code_size; // power of two
+} problem_t;
+
+/*
+ * Free space that was used by problem and everything it owns.
+ */
+void free_problem(problem_t *problem) {
+    for (int i = 0; i < problem -> C; ++i) {
+        free(problem -> courses[i] -> name);
+        free(problem -> courses[i]);
+    }
+    for (int i = 0; i < problem -> P; ++i) {
+        free(problem -> profs[i] -> name);
+        free(problem -> profs[i] -> courses);
+        free(problem -> profs[i]);
+    }
+    for (int i = 0; i < problem -> T; ++i) {
+        free(problem -> tas[i] -> courses);
+        free(problem -> tas[i] -> name);
+        free(problem -> tas[i]);
     }
 
-    free(flag);
-    free(buffer);
+    if (problem -> tas_pool != NULL) {
+        for (int i = 0; i < problem -> C; ++i) {
+            free(problem -> tas_pool[i]);
+        }
+        free(problem -> tas_pool);
+    }
+    if (problem -> profs_pool != NULL) {
+        for (int i = 0; i < problem -> C; ++i) {
+            free(problem -> profs_pool[i]);
+        }
+        free(problem -> profs_pool);
+    }
+    if (problem -> layout != NULL) free_layout(problem -> layout);
+
+    free(problem -> c_studs);
+    free(problem -> best);
+    free(problem -> code_ids);
+    free(problem -> courses);
+    free(problem -> profs);
+    free(problem -> tas);
+    if (problem -> roster != NULL) free_roster(problem -> roster);
+    free(problem);
+}
 
-    ta_t *ta = create_ta(id, name, courses);
+/*
+ * Place of code in code_ids of problem: where student with this code is or where they can be put.
+ */
+int code_slot(const problem_t *problem, const char *code) {
+    int i = (int) (mix64((unsigned long long) hash(code)) & (problem -> code_size - 1));
 
-    if (addTaToHashTable(thash, ta)) error = 1;
+    for (; problem -> code_ids[i] != -1; i = (i + 1) & (problem -> code_size - 1)) {
+        if (!compare_str(roster_code(problem -> roster, problem -> code_ids[i]), code)) break;
+    }
 
+    return i;
+}
 
-    if (courses[0] == 0 || state != P_COURSES || error) {
-        free(name);
-        free(courses);
-        free(ta);
-        return NULL;
+/*
+ * Put code of student id into code_ids of problem, growing it when it is half full.
+ */
+void index_code(problem_t *problem, int id) {
+    if (2 * (id + 1) > problem -> code_size) {
+        free(problem -> code_ids);
+        problem -> code_size *= 2;
+        problem -> code_ids = malloc(problem -> code_size * sizeof(int));
+        memset(problem -> code_ids, 0xFF, problem -> code_size * sizeof(int));
+        for (int i = 0; i < id; ++i) {
+            problem -> code_ids[code_slot(problem, roster_code(problem -> roster, i))] = i;
+        }
     }
 
-    return ta;
+    problem -> code_ids[code_slot(problem, roster_code(problem -> roster, id))] = id;
 }
 
 /*
- * Check whether the code is unique.
+ * Build code_ids of problem if it is not built yet (it is built on first change list).
  */
-int find_s_code(int S, char *code, student_t **studs) {
-    for (int i = 0; i < S; ++i) {
-        if (!compare_str(code, studs[i] -> code)) return 1;
+void index_codes(problem_t *problem) {
+    if (problem -> code_ids != NULL) return;
+
+    problem -> code_size = TABLE_SIZE;
+    problem -> code_ids = malloc(problem -> code_size * sizeof(int));
+    memset(problem -> code_ids, 0xFF, problem -> code_size * sizeof(int));
+    for (int i = 0; i < problem -> roster -> S; ++i) {
+        index_code(problem, i);
     }
-    return 0;
 }
 
 /*
- * Get student from string.
+ * Get id of student with the given code. If there is no such student: -1
  */
-student_t *get_s_line(int id, char *line, student_t **studs, chash_t *chash) {
-    int statesShifts[] = {S_SURNAME, S_CODE, S_COURSES, S_COURSES};
+int find_student(problem_t *problem, const char *code) {
+    index_codes(problem);
+    return problem -> code_ids[code_slot(problem, code)];
+}
 
-    char *name = malloc(BUFFER_SIZE);
-    char *surname = name;
-    char *code = malloc(STUDENT_CODE_SIZE);
-    int *courses = malloc(sizeof(int) * (MAX_COURSES + 1));
-    courses[0] = 0; // 0-th <- number of courses
+/*
+ * Apply one line of change list to students of problem and update c_studs:
+ *   new Name Surname CODE Course...  - new student, as a line of students section
+ *   add CODE Course...               - enroll student into courses
+ *   drop CODE Course...              - remove courses of student
+ *   remove CODE                      - remove all courses of student
+ * Empty line is skipped. If line is invalid: 1; otherwise: 0
+ */
+int apply_change(problem_t *problem, chash_t *chash, char *line) {
+    if (line[0] == '\n' || line[0] == '\0') return 0;
 
-    int state = S_NAME; // used for smart error handling
-    char *buffer = malloc(BUFFER_SIZE); // buffer for scanning
-    int error = 0, last_token = 0;
-    struct flag_s *flag = malloc(sizeof(struct flag_s));
-    clearFlag(flag);
+    roster_t *roster = problem -> roster;
+    char *buffer = malloc(BUFFER_SIZE);
+    struct flag_s flag;
+    int error = 0;
 
-    while (!last_token) {
-        line = nextToken(buffer, BUFFER_SIZE, line, flag);
-        if (state == S_NAME) {
-            if (flag->contains_digits || flag->contains_invalid_symbs) {
-                error = 1;
-                break;
-            }
-            strcpy(name, buffer);
-            name[flag->length] = ' ';
-            surname = name + flag->length + 1; // surname is shifted name, used for merging name and surname
-        } else if (state == S_SURNAME) {
-            if (flag->contains_digits || flag->contains_invalid_symbs) {
-                error = 1;
-                break;
+    clearFlag(&flag);
+    line = nextToken(buffer, BUFFER_SIZE, line, &flag);
+    if (flag.last_token) {
+        error = 1;
+    } else if (!strcmp(buffer, "new")) {
+        int id = roster -> S;
+
+        index_codes(problem); // before new student is added
+        if (get_s_line(line, chash, roster)) {
+            error = 1;
+        } else if (find_student(problem, roster_code(roster, id)) != -1) {
+            roster_cut(roster, id);
+            error = 1;
+        } else {
+            index_code(problem, id);
+            const int *courses = roster_courses(roster, id);
+            for (int j = 0; j < roster -> count[id]; ++j) {
+                problem -> c_studs[courses[j]]++;
             }
-            strcpy(surname, buffer);
-        } else if (state == S_CODE) {
-            if (flag->length != 5 || flag->contains_invalid_symbs) {
-                error = 1;
-                break;
+        }
+    } else if (!strcmp(buffer, "add") || !strcmp(buffer, "drop") || !strcmp(buffer, "remove")) {
+        int enroll = buffer[0] == 'a', drop_all = buffer[0] == 'r';
+
+        clearFlag(&flag);
+        line = nextToken(buffer, BUFFER_SIZE, line, &flag);
+        int id = flag.length == 5 && !flag.contains_invalid_symbs ? find_student(problem, buffer) : -1;
+        int last = flag.last_token != 0; // bit field is -1 when set
+
+        if (id == -1 || last != drop_all) error = 1;
+        else if (drop_all) {
+            const int *courses = roster_courses(roster, id);
+            for (int j = 0; j < roster -> count[id]; ++j) {
+                problem -> c_studs[courses[j]]--;
             }
+            roster -> count[id] = 0;
+        }
 
-            strcpy(code, buffer);
-        } else if (state == S_COURSES) {
-            int courseId;
-            if (flag->contains_digits || flag->contains_invalid_symbs ||
-                (courseId = getCourseIdFromHashTable(chash, buffer)) == -1) {
+        while (!error && !flag.last_token) {
+            int course;
+
+            clearFlag(&flag);
+            line = nextToken(buffer, BUFFER_SIZE, line, &flag);
+            if (flag.contains_digits || flag.contains_invalid_symbs || (course = getCourseIdFromHashTable(chash, buffer)) == -1) {
                 error = 1;
-                break;
+            } else if (enroll) {
+                roster_enroll(roster, id, course);
+                problem -> c_studs[course]++;
+            } else {
+                if (roster_drop(roster, id, course)) error = 1;
+                else problem -> c_studs[course]--;
             }
+        }
+    } else {
+        error = 1;
+    }
 
-            courses[++courses[0]] = courseId;
+    free(buffer);
+    return error;
+}
+
+/*
+ * Local search around genome: every round DELTA_MUTANTS mutants of the best genome are scored and the best one stays.
+ * Stops early when the best genome reaches bound (see lower_bound).
+ * Genome is replaced by the best one; returns its badness points.
+ */
+int polish_genome(const layout_t *layout, unsigned char *genome, int rounds, int bound, int P, int T, course_t **courses, professor_t **profs, ta_t **tas,
+                  int **profs_pool, int **tas_pool, int *c_studs) {
+    int C = layout -> C;
+    cpop_t *pop = create_cpop(layout, DELTA_MUTANTS + 1);
+    fcache_t *cache = create_fcache();
+    scratch_t *scratch = create_scratch(C, P, T, tas_pool);
+
+    memcpy(cpop_genome(pop, 0), genome, layout -> size);
+    pop -> hash[0] = genome_hash(layout, genome);
+    score_genomes(pop, 0, 1, P, T, courses, profs, tas, c_studs, scratch, cache, NULL);
+
+    for (int r = 0; r < rounds && pop -> badness[0] > bound; ++r) {
+        for (int j = 1; j < pop -> n; ++j) {
+            mutate_genome(layout, cpop_genome(pop, 0), cpop_genome(pop, j), P, T, courses, profs, tas, profs_pool, tas_pool, scratch -> work);
+            pop -> hash[j] = genome_hash(layout, cpop_genome(pop, j));
         }
+        score_genomes(pop, 1, pop -> n, P, T, courses, profs, tas, c_studs, scratch, cache, NULL);
 
-        last_token = flag->last_token;
-        clearFlag(flag);
-        state = statesShifts[state];
+        int old_badness = pop -> badness[0];
+        choose_best_genomes(pop, 1); // current genome stays on ties
+        if (pop -> badness[0] < old_badness) stats.improvements++;
+        stats.generations++;
     }
 
-    student_t *stud = create_student(id, name, code, courses);
-    if (find_s_code(id, code, studs)) error = 1;
+    memcpy(genome, cpop_genome(pop, 0), layout -> size);
+    int badness = pop -> badness[0];
+    stats.badness = badness;
+    stats.lower_bound = bound;
+    if (badness <= bound) stats.bound_reached++;
 
-    free(flag);
-    free(buffer);
+    free_scratch(scratch);
+    free_fcache(cache);
+    free_cpop(pop);
+    return badness;
+}
 
-    // if 0 courses or we did not reach courses or some error
-    if (courses[0] == 0 || state != S_COURSES || error) {
-        free(name);
-        free(courses);
-        free(stud);
-        return NULL;
+/*
+ * Improve kept solution of problem after its enrollments have changed.
+ * Cache of the search cannot be used, because badness depends on c_studs.
+ */
+int reoptimize_problem(problem_t *problem, int rounds) {
+    int bound = lower_bound(problem -> C, problem -> P, problem -> T, problem -> courses, problem -> profs, problem -> tas,
+                            problem -> tas_pool, problem -> c_studs);
+    return polish_genome(problem -> layout, problem -> best, rounds, bound, problem -> P, problem -> T, problem -> courses, problem -> profs, problem -> tas,
+                         problem -> profs_pool, problem -> tas_pool, problem -> c_studs);
+}
+
+/*
+ * One component as separate instance with its own ids, solved by solve_part.
+ */
+typedef struct part_s {
+    int index; // number of component
+    int C, P, T;
+    int *course_ids; // global ids of local courses, profs and TAs
+    int *prof_ids;
+    int *ta_ids;
+    course_t *course_data; // copies of courses, profs and TAs with local ids; names are shared with instance
+    professor_t *prof_data;
+    ta_t *ta_data;
+    course_t **courses;
+    professor_t **profs;
+    ta_t **tas;
+    int **profs_pool;
+    int **tas_pool;
+    int *c_studs;
+    config_t cfg;
+    unsigned long long seed; // seed of random sequence of solve_part
+    lane_t *lane; // lane of portfolio solver whose thread solves component or NULL
+    ind_t *sol;
+    stats_t stats; // counters of solve_part
+} part_t;
+
+/*
+ * Copy list of global course ids as local ids of component.
+ */
+int *local_courses(const int *courses, const int *local) {
+    int *copy = malloc((courses[0] + 1) * sizeof(int));
 
+    copy[0] = courses[0];
+    for (int j = 1; j < courses[0] + 1; ++j) {
+        copy[j] = local[courses[j]];
     }
 
-    return stud;
+    return copy;
 }
 
 /*
- * Generate first (zero) population.
+ * Sizes of genetic algorithm for component with share of all courses, at least MIN_PART_POPULATION individuals.
  */
-ind_t **generate_population_zero(int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **tas_pool, int *c_studs) {
-    ind_t **pop0 = malloc(POPULATION_SIZE * sizeof(ind_t *)); // free here
-    for (int j = 0; j < POPULATION_SIZE; ++j) {
-        pop0[j] = create_ind(C, P, T, courses, profs, tas, tas_pool, c_studs); // create random individual
+void scale_config(const config_t *cfg, double share, config_t *part_cfg) {
+    *part_cfg = *cfg;
+    part_cfg -> population_size = maximum(MIN_PART_POPULATION, (int) (cfg -> population_size * share));
+
+    double factor = (double) part_cfg -> population_size / cfg -> population_size;
+    part_cfg -> best_size = maximum(1, (int) (cfg -> best_size * factor));
+    part_cfg -> kids_size = (int) (cfg -> kids_size * factor);
+    part_cfg -> mutation_size = (int) (cfg -> mutation_size * factor);
+    if (part_cfg -> best_size + part_cfg -> kids_size + part_cfg -> mutation_size > part_cfg -> population_size) {
+        part_cfg -> kids_size = part_cfg -> mutation_size = 0;
     }
-    return pop0;
+    part_cfg -> time_budget = cfg -> time_budget * share;
 }
 
-ind_t *get_best_sol(int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int **tas_pool, int *c_studs) {
-    ind_t **cur_pop = generate_population_zero(C, P, T, courses, profs, tas, tas_pool, c_studs);
+/*
+ * Create component k of instance. local[i] is id of course, prof or TA inside its component.
+ */
+part_t *create_part(int k, const config_t *cfg, int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas, int *c_studs,
+                    const int *component, const int *local_course) {
+    part_t *part = calloc(1, sizeof(part_t));
+    part -> index = k;
+
+    part -> course_ids = malloc((C + 1) * sizeof(int));
+    for (int i = 0; i < C; ++i) {
+        if (component[i] == k) part -> course_ids[part -> C++] = i;
+    }
+    part -> prof_ids = malloc((P + 1) * sizeof(int));
+    for (int p = 0; p < P; ++p) {
+        if (component[profs[p] -> courses[1]] == k) part -> prof_ids[part -> P++] = p;
+    }
+    part -> ta_ids = malloc((T + 1) * sizeof(int));
+    for (int t = 0; t < T; ++t) {
+        if (component[tas[t] -> courses[1]] == k) part -> ta_ids[part -> T++] = t;
+    }
 
-    for (int i = 0; i < GENERATIONS_NUMBER; ++i) {
-        choose_best_inds(C, cur_pop);
+    part -> course_data = malloc((part -> C + 1) * sizeof(course_t));
+    part -> courses = malloc((part -> C + 1) * sizeof(course_t *));
+    part -> c_studs = malloc((part -> C + 1) * sizeof(int));
+    for (int i = 0; i < part -> C; ++i) {
+        part -> course_data[i] = *courses[part -> course_ids[i]];
+        part -> course_data[i].id = i;
+        part -> courses[i] = &part -> course_data[i];
+        part -> c_studs[i] = c_studs[part -> course_ids[i]];
     }
-    choose_best_inds(C, cur_pop);
-    for (int i = 1; i < BEST_SIZE; ++i) {
-        free_ind(C, cur_pop[i]);
+
+    part -> prof_data = malloc((part -> P + 1) * sizeof(professor_t));
+    part -> profs = malloc((part -> P + 1) * sizeof(professor_t *));
+    for (int p = 0; p < part -> P; ++p) {
+        part -> prof_data[p] = *profs[part -> prof_ids[p]];
+        part -> prof_data[p].id = p;
+        part -> prof_data[p].courses = local_courses(profs[part -> prof_ids[p]] -> courses, local_course);
+        part -> profs[p] = &part -> prof_data[p];
     }
 
-    ind_t *best = cur_pop[0];
-    free(cur_pop);
-    return best;
+    part -> ta_data = malloc((part -> T + 1) * sizeof(ta_t));
+    part -> tas = malloc((part -> T + 1) * sizeof(ta_t *));
+    for (int t = 0; t < part -> T; ++t) {
+        part -> ta_data[t] = *tas[part -> ta_ids[t]];
+        part -> ta_data[t].id = t;
+        part -> ta_data[t].courses = local_courses(tas[part -> ta_ids[t]] -> courses, local_course);
+        part -> tas[t] = &part -> ta_data[t];
+    }
+
+    part -> profs_pool = create_profs_pool(part -> C, part -> P, part -> profs);
+    part -> tas_pool = create_tas_pool(part -> C, part -> T, part -> tas);
+    scale_config(cfg, (double) part -> C / C, &part -> cfg);
+
+    return part;
 }
 
 /*
- * Is a in arr. arr[0] = size of arr;
+ * Free space that was used by component and its solution.
  */
-int is_in_courses(int a, const int *arr) {
-    for (int i = 1; i < arr[0] + 1; ++i) {
-        if (arr[i] == a) return 1;
+void free_part(part_t *part) {
+    for (int i = 0; i < part -> C; ++i) {
+        free(part -> profs_pool[i]);
+        free(part -> tas_pool[i]);
     }
-    return 0;
+    for (int p = 0; p < part -> P; ++p) {
+        free(part -> prof_data[p].courses);
+    }
+    for (int t = 0; t < part -> T; ++t) {
+        free(part -> ta_data[t].courses);
+    }
+    if (part -> sol != NULL) free_ind(part -> C, part -> sol);
+
+    free(part -> profs_pool);
+    free(part -> tas_pool);
+    free(part -> c_studs);
+    free(part -> courses);
+    free(part -> profs);
+    free(part -> tas);
+    free(part -> course_data);
+    free(part -> prof_data);
+    free(part -> ta_data);
+    free(part -> course_ids);
+    free(part -> prof_ids);
+    free(part -> ta_ids);
+    free(part);
 }
 
 /*
- * Print final version to existing output file.
+ * Task of worker pool: solve one component. Every component has its own random sequence,
+ * so the result does not depend on threads.
  */
-void format_ind(int C, int P, int T, int S, course_t **courses, professor_t **profs, ta_t **tas, student_t **studs, ind_t *ind, FILE *out) {
-    if (out == NULL) return;
-
-    int *courses_places = malloc(C * sizeof(int)); // how many places exist for each course
-    int *profs_flags = malloc(P * sizeof(int)); // flags for professors
-    int *profs_un_c = malloc(P * sizeof(int)); // used for storing untrained course
-    memset(profs_flags, 0, P * sizeof(int));
-    memset(profs_un_c, 0, P * sizeof(int));
-
-    int *tas_busy = malloc(T * sizeof(int)); // how busy tas are
-    memset(tas_busy, 0, T * sizeof(int));
+void *solve_part(void *arg) {
+    part_t *part = *(part_t **) arg;
+
+    rng_seed(&rng, part -> seed);
+    memset(&stats, 0, sizeof(stats));
+    perf.enabled = part -> cfg.profile;
+    int outer = perf_phase(PHASE_SEARCH);
+    if (part -> cfg.steady)
+        part -> sol = get_steady_sol(&part -> cfg, NULL, part -> C, part -> P, part -> T, part -> courses, part -> profs, part -> tas,
+                                     part -> profs_pool, part -> tas_pool, part -> c_studs, part -> lane);
+    else
+        part -> sol = get_best_sol(&part -> cfg, part -> C, part -> P, part -> T, part -> courses, part -> profs, part -> tas,
+                                   part -> profs_pool, part -> tas_pool, part -> c_studs, NULL, NULL, NULL, NULL, part -> lane);
+    perf_phase(outer);
+    if (outer == -1) perf_close();
+    part -> stats = stats;
 
-    for (int i = 0; i < C; ++i) {
-        if (ind -> cinds[i] -> runnable) {
-            courses_places[i] = ind -> cinds[i] -> course -> students_number;
+    return NULL;
+}
 
-            fprintf(out, "%s\n%s\n", ind -> cinds[i] -> course -> name, ind -> cinds[i] -> prof -> name);
-            if (!prof_has_course(ind -> cinds[i] -> prof, ind -> cinds[i] -> course)) { // if course is untrained
-                profs_flags[ind -> cinds[i] -> prof -> id] = UNTRAINED_COURSE;
-                profs_un_c[ind -> cinds[i] -> prof -> id] = ind -> cinds[i] -> course -> id;
-            } else {
+/*
+ * Compare components by number of courses, larger first.
+ */
+int compare_parts(const void *a, const void *b) {
+    const part_t *x = *(part_t * const *) a, *y = *(part_t * const *) b;
+    return x -> C != y -> C ? y -> C - x -> C : x -> index - y -> index;
+}
 
-                if (profs_flags[ind -> cinds[i] -> prof -> id] == UNDEFINED) { // if 0 courses
-                    profs_flags[ind -> cinds[i] -> prof -> id] = LACKING_COURSE; // then lacking
-                }
-                else if (profs_flags[ind -> cinds[i] -> prof -> id] == LACKING_COURSE)
-                    profs_flags[ind -> cinds[i] -> prof -> id] = TWO_COURSES; // 2 courses, no problems
+/*
+ * Solve components of instance separately on threads of pool (if pool is NULL, one after another on calling thread), merge their solutions
+ * and improve the merged one by local search, which can also give idle profs to courses of other components.
+ * If lane is not NULL, components are solved for this lane of portfolio: they stop when it is over and take seeds of their own.
+ * If instance has only one component: NULL
+ */
+ind_t *get_split_sol(const config_t *cfg, pool_t *pool, int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas,
+                     int **profs_pool, int **tas_pool, int *c_studs, lane_t *lane) {
+    int *component = malloc((C + 1) * sizeof(int));
+    int n = find_components(C, P, T, profs, tas, component);
+    if (n < 2) {
+        free(component);
+        return NULL;
+    }
 
-            }
+    int *local_course = malloc((C + 1) * sizeof(int));
+    int *part_size = calloc((size_t) n, sizeof(int));
+    for (int i = 0; i < C; ++i) {
+        local_course[i] = part_size[component[i]]++;
+    }
 
-            for (int j = 0; j < ind -> cinds[i] -> ta_number; ++j) {
-                tas_busy[ind -> cinds[i] -> tas[j] -> ta -> id] += ind -> cinds[i] -> tas[j] -> number;
-                for (int k = 0; k < ind -> cinds[i] -> tas[j] -> number; ++k) {
-                    fprintf(out, "%s\n", ind -> cinds[i] -> tas[j] -> ta -> name);
-                }
-            }
+    lane_t part_lane; // genomes of components do not fit layout of portfolio
+    if (lane != NULL) {
+        part_lane = *lane;
+        part_lane.shares = 0;
+    }
 
-            int st_num = 0;
-            for (int j = 0; j < S; ++j) {
-                if (is_in_courses(i, studs[j]->courses)) {
-                    ++st_num;
-                    fprintf(out, "%s %s\n", studs[j] -> name, studs[j] -> code);
-                    if (st_num == courses_places[i])
-                        break;
+    part_t **parts = malloc(n * sizeof(part_t *));
+    for (int k = 0; k < n; ++k) {
+        parts[k] = create_part(k, cfg, C, P, T, courses, profs, tas, c_studs, component, local_course);
+        // lanes of portfolio take sequences of their own, apart from those of other lanes
+        parts[k] -> seed = SEED + k + (lane != NULL ? (unsigned long long) lane -> index << 32 : 0);
+        parts[k] -> lane = lane != NULL ? &part_lane : NULL;
+    }
+    qsort(parts, (size_t) n, sizeof(part_t *), compare_parts); // large components are taken first
+
+    stats_t saved_stats = stats; // calling thread solves components too
+    rng_t saved_rng = rng;
+    if (pool != NULL) pool_run(pool, n, solve_part, parts, sizeof(part_t *));
+    else {
+        for (int k = 0; k < n; ++k) {
+            solve_part(&parts[k]);
+        }
+    }
+    stats = saved_stats;
+    rng = saved_rng;
+
+    layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+    unsigned char *genome = malloc(layout -> size + 1);
+    memset(genome, 0xFF, layout -> size);
+    for (int k = 0; k < n; ++k) {
+        part_t *part = parts[k];
+        add_stats(&stats, &part -> stats);
+
+        for (int i = 0; i < part -> C; ++i) {
+            cind_t *cind = part -> sol -> cinds[i];
+            int course = part -> course_ids[i];
+            if (!cind -> runnable) continue;
+
+            gene_set(layout, genome, course, part -> prof_ids[cind -> prof -> id]);
+            int slot = layout -> lab_offset[course];
+            for (int j = 0; j < cind -> ta_number; ++j) {
+                for (int l = 0; l < cind -> tas[j] -> number && slot < layout -> lab_offset[course + 1]; ++l) {
+                    gene_set(layout, genome, slot++, part -> ta_ids[cind -> tas[j] -> ta -> id]);
                 }
             }
-
-            fprintf(out, "\n");
-        } else {
-            courses_places[i] = -1;
         }
+        free_part(part);
     }
+    stats.components = n;
+    stats.diversity /= n; // average of components; their mutants and parents are summed
+    stats.lowest_diversity /= n;
+
+    int bound = lower_bound(C, P, T, courses, profs, tas, tas_pool, c_studs);
+    int badness = polish_genome(layout, genome, POLISH_ROUNDS, bound, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs);
+    ind_t *best = decode_ind(layout, genome, courses, profs, tas);
+    best -> badness_points = badness;
+
+    free(genome);
+    free_layout(layout);
+    free(parts);
+    free(part_size);
+    free(local_course);
+    free(component);
+    return best;
+}
 
-    for (int i = 0; i < C; ++i) {
-        if (courses_places[i] == -1) {
-            fprintf(out, "%s cannot be run.\n", courses[i] -> name);
-            courses_places[i] = 0;
-        }
+/*
+ * Find the best individual by local search (see polish_genome) from greedy genome, in rounds of POLISH_ROUNDS,
+ * exchanging the genome with other lanes of portfolio after every round. Takes as many rounds as would score
+ * as many individuals as cfg -> generations_number generations, unless lane is over before.
+ */
+ind_t *get_local_sol(const config_t *cfg, lane_t *lane, int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas,
+                     int **profs_pool, int **tas_pool, int *c_studs) {
+    layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+    work_t *work = create_work(C, P, T, tas_pool);
+    unsigned char *genome = malloc(layout -> size + 1);
+    long long rounds = (long long) cfg -> generations_number * cfg -> population_size / DELTA_MUTANTS;
+    int bound = lane -> portfolio -> bound;
+
+    rank_courses(work, C, courses, tas_pool, c_studs);
+    greedy_genome(layout, genome, P, T, courses, profs, profs_pool, tas_pool, work);
+    int badness = lane_share(lane, genome, genome_badness(layout, genome, P, T, courses, c_studs, work));
+    for (long long round = 0; round < rounds && badness > bound && !lane_over(lane); round += POLISH_ROUNDS) {
+        badness = polish_genome(layout, genome, POLISH_ROUNDS, bound, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs);
+        badness = lane_share(lane, genome, badness);
     }
 
-    for (int i = 0; i < P; ++i) {
-        if (profs_flags[i] == UNDEFINED) {
-            fprintf(out, "%s is unassigned.\n", profs[i] -> name);
-        }
+    ind_t *best = decode_ind(layout, genome, courses, profs, tas);
+    best -> badness_points = badness;
+
+    free(genome);
+    free_work(work);
+    free_layout(layout);
+    return best;
+}
+
+/*
+ * Task of worker pool: run strategy of lane with its own seed and offer its solution to portfolio.
+ */
+void *portfolio_task(void *arg) {
+    lane_t *lane = arg;
+    portfolio_t *portfolio = lane -> portfolio;
+    config_t cfg = *portfolio -> cfg;
+    int C = portfolio -> C, P = portfolio -> P, T = portfolio -> T;
+    course_t **courses = portfolio -> courses;
+    professor_t **profs = portfolio -> profs;
+    ta_t **tas = portfolio -> tas;
+    int **profs_pool = portfolio -> profs_pool, **tas_pool = portfolio -> tas_pool, *c_studs = portfolio -> c_studs;
+    ind_t *sol = NULL;
+
+    rng_seed(&rng, SEED + lane -> index);
+    memset(&stats, 0, sizeof(stats));
+    perf.enabled = cfg.profile;
+    int outer = perf_phase(PHASE_SEARCH);
+    lane -> start = thread_seconds();
+
+    if (lane -> strategy == STRATEGY_COMPONENTS) {
+        cfg.time_budget = portfolio -> lane_seconds; // split among components, which are solved one after another
+        sol = get_split_sol(&cfg, NULL, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, lane);
+        if (sol == NULL) lane -> strategy = STRATEGY_GENERATIONS; // instance has one component
+    }
+    cfg.time_budget = 0; // other strategies are stopped by lane_over
+
+    if (sol == NULL) {
+        if (lane -> strategy == STRATEGY_STEADY)
+            sol = get_steady_sol(&cfg, NULL, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, lane);
+        else if (lane -> strategy == STRATEGY_LOCAL)
+            sol = get_local_sol(&cfg, lane, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs);
+        else
+            sol = get_best_sol(&cfg, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, NULL, NULL, NULL, NULL, lane);
     }
 
-    for (int i = 0; i < P; ++i) {
-        if (profs_flags[i] == UNTRAINED_COURSE) {
-            fprintf(out, "%s is not trained for %s.\n", profs[i] -> name, courses[profs_un_c[i]]->name);
-        } else if (profs_flags[i] == LACKING_COURSE) {
-            fprintf(out, "%s is lacking class.\n", profs[i] -> name);
-        }
-    }
+    unsigned char *genome = malloc(portfolio -> layout -> size + 1);
+    encode_ind(portfolio -> layout, sol, genome);
+    lane_share(lane, genome, sol -> badness_points);
+    free(genome);
+    free_ind(C, sol);
 
-    for (int i = 0; i < T; ++i) {
-        if (4 - tas_busy[i] > 0) {
-            fprintf(out, "%s is lacking %d lab(s).\n", tas[i] -> name, 4 - tas_busy[i]);
-        }
-    }
+    perf_phase(outer);
+    if (outer == -1) perf_close();
+    lane -> stats = stats;
+    return NULL;
+}
 
-    for (int i = 0; i < S; ++i) {
-        for (int j = 1; j < studs[i] -> courses[0] + 1; ++j) {
-            if (courses_places[studs[i] -> courses[j]] == 0) {
-                fprintf(out, "%s is lacking %s.\n", studs[i] -> name, courses[studs[i] -> courses[j]] -> name);
-            } else {
-                courses_places[studs[i] -> courses[j]]--;
-            }
-        }
+/*
+ * Race strategies on threads of pool and take the best solution. Lane k runs strategy k % PORTFOLIO_STRATEGIES
+ * with seed SEED + k; there are as many lanes as threads, but at least one per strategy.
+ * Lanes exchange their best genomes while they search and all stop when one of them reaches the lower bound.
+ * Time budget is split evenly among lanes and measured in CPU time of their threads, so all lanes
+ * together use as much CPU time as one search would. With more than one thread the result depends on their timing.
+ */
+ind_t *get_portfolio_sol(const config_t *cfg, pool_t *pool, int C, int P, int T, course_t **courses, professor_t **profs, ta_t **tas,
+                         int **profs_pool, int **tas_pool, int *c_studs) {
+    int threads = pool -> workers + 1;
+    int n = maximum(threads, PORTFOLIO_STRATEGIES);
+    layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+    portfolio_t portfolio = {
+            .cfg = cfg, .C = C, .P = P, .T = T, .courses = courses, .profs = profs, .tas = tas,
+            .profs_pool = profs_pool, .tas_pool = tas_pool, .c_studs = c_studs,
+            .layout = layout, .best = malloc(layout -> size + 1), .badness = MAX_BADNESS_POINTS, .winner = -1,
+            .bound = lower_bound(C, P, T, courses, profs, tas, tas_pool, c_studs), .reached = 0,
+            .lane_seconds = cfg -> time_budget * threads / n
+    };
+    pthread_mutex_init(&portfolio.lock, NULL);
+
+    lane_t *lanes = malloc(n * sizeof(lane_t));
+    for (int k = 0; k < n; ++k) {
+        lanes[k] = (lane_t) {.portfolio = &portfolio, .index = k, .strategy = k % PORTFOLIO_STRATEGIES, .shares = 1};
     }
-    fprintf(out, "Total score is %d.", ind -> badness_points);
 
+    stats_t saved_stats = stats; // calling thread runs lanes too
+    rng_t saved_rng = rng;
+    pool_run(pool, n, portfolio_task, lanes, sizeof(lane_t));
+    stats = saved_stats;
+    rng = saved_rng;
+    for (int k = 0; k < n; ++k) {
+        add_stats(&stats, &lanes[k].stats);
+    }
 
-    // free everything
-    free(courses_places);
-    free(profs_flags);
-    free(profs_un_c);
-    free(tas_busy);
+    // every lane offers its solution, so there is a winner; sizes of search are those of its lane
+    const stats_t *won = &lanes[portfolio.winner].stats;
+    stats.genome_bytes = won -> genome_bytes;
+    stats.population_bytes = won -> population_bytes;
+    stats.distinct = won -> distinct;
+    stats.components = won -> components;
+    stats.diversity = won -> diversity;
+    stats.lowest_diversity = won -> lowest_diversity;
+    stats.mutation_size = won -> mutation_size;
+    stats.best_size = won -> best_size;
+    stats.badness = portfolio.badness;
+    stats.lower_bound = portfolio.bound;
+    stats.bound_reached = portfolio.badness <= portfolio.bound;
+    stats.lanes = n;
+    stats.winner = portfolio.winner;
+    stats.winner_strategy = lanes[portfolio.winner].strategy;
+
+    ind_t *best = decode_ind(layout, portfolio.best, courses, profs, tas);
+    best -> badness_points = portfolio.badness;
+
+    pthread_mutex_destroy(&portfolio.lock);
+    free(lanes);
+    free(portfolio.best);
+    free_layout(layout);
+    return best;
 }
 
 /*
- * Print error in existing output file.
+ * Solver context: configuration and everything solve reuses between inputs.
  */
-void print_error(FILE *file) {
-    fprintf(file, "Invalid input.");
+struct solver_context_s {
+    config_t cfg;
+    chash_t *chash;
+    phash_t *phash;
+    thash_t *thash;
+    shash_t *shash;
+    lines_t *s_lines; // students section is parsed after it is read (see parse_students)
+    char *line;
+    pool_t *pool;
+    problem_t *problem; // last valid input, NULL if there is none
+};
+
+/*
+ * Create solver context with configuration cfg.
+ */
+solver_t *create_solver(const config_t *cfg) {
+    solver_t *solver = malloc(sizeof(solver_t));
+
+    solver -> cfg = *cfg;
+    solver -> chash = create_courses_hashtable();
+    solver -> phash = create_profs_hashtable();
+    solver -> thash = create_tas_hashtable();
+    solver -> shash = create_codes_hashtable();
+    solver -> s_lines = create_lines();
+    solver -> line = malloc(500);
+    solver -> pool = create_pool(count_threads(cfg -> threads));
+    solver -> problem = NULL;
+
+    return solver;
+}
+
+solver_t *solver_create(int argc, char **argv) {
+    config_t cfg;
+    default_config(&cfg);
+    if (parse_config(&cfg, argc, argv)) return NULL;
+
+    return create_solver(&cfg);
+}
+
+void solver_free(solver_t *solver) {
+    if (solver == NULL) return;
+
+    if (solver -> problem != NULL) free_problem(solver -> problem);
+    free_pool(solver -> pool);
+    free(solver -> line);
+    free_lines(solver -> s_lines);
+    free_codes_hashtable(solver -> shash);
+
+    free(solver -> thash -> tas);
+    free(solver -> thash);
+
+    free(solver -> phash -> professors);
+    free(solver -> phash);
+
+    clearCoursesHashTable(solver -> chash);
+    free(solver -> chash -> courses);
+    free(solver -> chash);
+
+    free(solver);
 }
 
 /*
- * Solve task for given existing file input and output.
+ * Solve task for given existing file input and output with solver context. If input is valid: 0; otherwise: 1
+ * If front is not NULL, Pareto front of all individuals is written there.
+ * If checkpoint is not NULL, it is the name of checkpoint file of this input (see get_best_sol).
+ * If stream is not NULL, improvements of the best individual are written there during the search.
  */
-void solve(FILE *input, FILE *output) {
-    srand(SEED);
+int solve(solver_t *solver, FILE *input, FILE *output, FILE *front, const char *checkpoint, FILE *stream) {
+    const config_t *cfg = &solver -> cfg;
+    rng_seed(&rng, SEED);
+    memset(&stats, 0, sizeof(stats));
+    perf.enabled = cfg -> profile;
+    perf_phase(PHASE_PARSE);
+
+    if (solver -> problem != NULL) free_problem(solver -> problem);
+    solver -> problem = NULL;
+    clearCoursesHashTable(solver -> chash);
+    clearProfsHashTable(solver -> phash);
+    clearTasHashTable(solver -> thash);
+    clearCodesHashTable(solver -> shash);
 
     int C = 0, P = 0, T = 0, S = 0;
-    course_t **courses = malloc(MAX_COURSES * sizeof(course_t *));
-    professor_t **profs = malloc(MAX_COURSES * sizeof(professor_t *));
-    ta_t **tas = malloc(MAX_COURSES * sizeof(ta_t *));
-    student_t **studs = malloc(MAX_STUDENTS * sizeof(student_t *));
+    int C_cap = MAX_COURSES, P_cap = MAX_COURSES, T_cap = MAX_COURSES; // arrays grow when full
+    course_t **courses = malloc(C_cap * sizeof(course_t *));
+    professor_t **profs = malloc(P_cap * sizeof(professor_t *));
+    ta_t **tas = malloc(T_cap * sizeof(ta_t *));
+    roster_t *roster = create_roster();
+    lines_t *s_lines = solver -> s_lines;
+    clear_lines(s_lines);
 
     int *c_studs = NULL;
 
-    chash_t *chash = create_courses_hashtable();
-    phash_t *phash = create_profs_hashtable();
-    thash_t *thash = create_tas_hashtable();
+    chash_t *chash = solver -> chash;
+    phash_t *phash = solver -> phash;
+    thash_t *thash = solver -> thash;
+    shash_t *shash = solver -> shash;
 
     int **tas_pool = NULL;
+    int **profs_pool = NULL;
+    layout_t *layout = NULL;
+    unsigned char *best = NULL; // genome of solution
 
     int wait[] = {'P', 'T', 'S', 256};
     int state = I_COURSES;
 
-    char *line = malloc(500);
+    char *line = solver -> line;
     int error = 0;
+    line[0] = '\0';
     fgets(line, 500, input);
     while (1) {
         if (line[0] == wait[state]) {
             if (line[1] == '\n' || line[1] == '\0') {
                 state++;
+                if (state == I_PROFESSORS) freezeCoursesHashTable(chash, C, courses);
                 if (feof(input)) break;
                 fgets(line, 500, input);
                 continue;
@@ -1252,6 +5691,7 @@ void solve(FILE *input, FILE *output) {
                 error = 1;
                 break;
             }
+            courses = reserve_ptrs(courses, C, &C_cap);
             courses[C++] = course;
         } else if (state == I_PROFESSORS) {
             professor_t *professor = get_p_line(P, line, chash, phash);
@@ -1259,6 +5699,7 @@ void solve(FILE *input, FILE *output) {
                 error = 1;
                 break;
             }
+            profs = reserve_ptrs(profs, P, &P_cap);
             profs[P++] = professor;
         } else if (state == I_TAS) {
             ta_t *ta = get_t_line(T, line, chash, thash);
@@ -1267,82 +5708,177 @@ void solve(FILE *input, FILE *output) {
                 break;
             }
 
+            tas = reserve_ptrs(tas, T, &T_cap);
             tas[T++] = ta;
         } else if (state == I_STUDENTS) {
-            student_t *student = get_s_line(S, line, studs, chash);
-            if (student == NULL) {
-                error = 1;
-                break;
-            }
-
-            studs[S++] = student;
+            add_line(s_lines, line);
         }
 
         if (feof(input)) break;
         fgets(line, 500, input);
     }
 
+    if (state == I_STUDENTS && !error) {
+        S = parse_students(s_lines, chash, shash, solver -> pool, roster, &error);
+    }
+
     if (state != I_STUDENTS || error) {
         print_error(output);
     } else {
+        perf_phase(PHASE_POOLS);
         tas_pool = create_tas_pool(C, T, tas);
-        c_studs = create_c_studs(C, S, studs);
+        profs_pool = create_profs_pool(C, P, profs);
+        c_studs = create_c_studs(C, roster);
+        perf_phase(PHASE_SEARCH);
 
-        ind_t *sol = get_best_sol(C, P, T, courses, profs, tas, tas_pool, c_studs);
-        format_ind(C, P, T, S, courses, profs, tas, studs, sol, output);
-    }
+        archive_t *archive = front != NULL ? create_archive() : NULL;
 
+        ckpt_t *resume = NULL;
+        if (checkpoint != NULL && cfg -> resume) {
+            layout_t *layout = create_layout(C, P, T, courses, tas_pool);
+            resume = read_checkpoint(checkpoint, layout, instance_fingerprint(C, P, T, courses, profs_pool, tas_pool, c_studs));
+            free_layout(layout);
+        }
 
-    for (int i = 0; i < C; ++i) {
-        free(courses[i]->name);
-        free(courses[i]);
+        config_t run_cfg = *cfg;
+        if (resume != NULL) apply_checkpoint_config(&run_cfg, resume);
+        else if (run_cfg.auto_tune) auto_tune_config(&run_cfg, C, P, T, S, courses, profs, profs_pool, tas_pool, c_studs);
+
+        ind_t *sol = NULL;
+        // portfolio, components and steady-state search are used only by plain search: front, checkpoints and stream follow generations
+        int plain = archive == NULL && stream == NULL && checkpoint == NULL;
+        if (run_cfg.portfolio && plain)
+            sol = get_portfolio_sol(&run_cfg, solver -> pool, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs);
+        if (sol == NULL && run_cfg.split && plain)
+            sol = get_split_sol(&run_cfg, solver -> pool, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, NULL);
+        if (sol == NULL && run_cfg.steady && plain)
+            sol = get_steady_sol(&run_cfg, solver -> pool, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, NULL);
+        if (sol == NULL)
+            sol = get_best_sol(&run_cfg, C, P, T, courses, profs, tas, profs_pool, tas_pool, c_studs, archive,
+                               cfg -> checkpoint_seconds > 0 ? checkpoint : NULL, resume, stream, NULL);
+        if (resume != NULL) free_checkpoint(resume);
+        perf_phase(PHASE_OUTPUT);
+        format_ind(C, P, T, courses, profs, tas, roster, sol, output);
+
+        layout = create_layout(C, P, T, courses, tas_pool);
+        best = malloc(layout -> size + 1);
+        encode_ind(layout, sol, best);
+        free_ind(C, sol);
+
+        if (archive != NULL) {
+            write_front(archive, front);
+            free_archive(archive);
+        }
+        perf_phase(-1);
+        if (cfg -> print_stats) print_stats(stderr);
     }
-    for (int i = 0; i < P; ++i) {
-        free(profs[i]->name);
-        free(profs[i]->courses);
-        free(profs[i]);
+    perf_close();
+
+    problem_t *problem = malloc(sizeof(problem_t));
+    *problem = (problem_t) {
+            .C = C, .P = P, .T = T,
+            .courses = courses, .profs = profs, .tas = tas, .roster = roster,
+            .profs_pool = profs_pool, .tas_pool = tas_pool, .c_studs = c_studs,
+            .layout = layout, .best = best, .code_ids = NULL, .code_size = 0
+    };
+
+    // tables keep pointing to names of kept problem until next input
+    if (state != I_STUDENTS || error) free_problem(problem);
+    else solver -> problem = problem;
+
+    return state != I_STUDENTS || error;
+}
+
+/*
+ * Apply change list of students to the last valid input of solver, re-optimize its solution and write it into output.
+ * After invalid change list, solver has no input to change until the next call of solve.
+ * If change list is valid: 0; otherwise: 1
+ */
+int solve_delta(solver_t *solver, FILE *changes, FILE *output) {
+    problem_t *problem = solver -> problem;
+    char *line = solver -> line;
+    int error = problem == NULL;
+
+    rng_seed(&rng, SEED);
+    memset(&stats, 0, sizeof(stats));
+    perf.enabled = solver -> cfg.profile;
+    perf_phase(PHASE_PARSE);
+
+    while (!error && fgets(line, 500, changes) != NULL) {
+        error = apply_change(problem, solver -> chash, line);
     }
-    for (int i = 0; i < T; ++i) {
-        free(tas[i]->courses);
-        free(tas[i]->name);
-        free(tas[i]);
+
+    if (error) {
+        perf_close();
+        print_error(output);
+        if (problem != NULL) free_problem(problem);
+        solver -> problem = NULL;
+        return 1;
     }
-    for (int i = 0; i < S; ++i) {
-        free(studs[i]->name);
-        free(studs[i]->courses);
-        free(studs[i]->code);
-        free(studs[i]);
+
+    perf_phase(PHASE_SEARCH);
+    int badness = reoptimize_problem(problem, solver -> cfg.delta_rounds);
+    ind_t *sol = decode_ind(problem -> layout, problem -> best, problem -> courses, problem -> profs, problem -> tas);
+    sol -> badness_points = badness;
+    perf_phase(PHASE_OUTPUT);
+    format_ind(problem -> C, problem -> P, problem -> T, problem -> courses, problem -> profs, problem -> tas, problem -> roster, sol, output);
+    free_ind(problem -> C, sol);
+    perf_phase(-1);
+    perf_close();
+
+    if (solver -> cfg.print_stats) print_stats(stderr);
+    return 0;
+}
+
+int solver_apply_delta(solver_t *solver, const char *changes, size_t changes_size, char **output, size_t *output_size) {
+    *output = NULL;
+    *output_size = 0;
+
+    FILE *in = changes_size > 0 ? fmemopen((void *) changes, changes_size, "r") : fopen("/dev/null", "r");
+    if (in == NULL) return -1;
+    FILE *out = open_memstream(output, output_size);
+    if (out == NULL) {
+        fclose(in);
+        return -1;
     }
 
-    free(line);
+    int invalid = solve_delta(solver, in, out);
 
-    if (c_studs != NULL)
-        free(c_studs);
+    fclose(in);
+    fclose(out);
+    return invalid;
+}
 
-    if (tas_pool != NULL) {
-        for (int i = 0; i < C; ++i) {
-            free(tas_pool[i]);
-        }
+int solver_solve_buffer(solver_t *solver, const char *input, size_t input_size, char **output, size_t *output_size) {
+    *output = NULL;
+    *output_size = 0;
 
-        free(tas_pool);
+    FILE *in = input_size > 0 ? fmemopen((void *) input, input_size, "r") : fopen("/dev/null", "r");
+    if (in == NULL) return -1;
+    FILE *out = open_memstream(output, output_size);
+    if (out == NULL) {
+        fclose(in);
+        return -1;
     }
 
-    free(chash->courses);
-    free(chash);
-
-    free(phash->professors);
-    free(phash);
+    int invalid = solve(solver, in, out, NULL, NULL, NULL);
 
-    free(thash->tas);
-    free(thash);
+    fclose(in);
+    fclose(out);
+    return invalid;
 }
 
 /*
  * Scan all files from input50.txt to input1.txt and solve task for existing files.
  */
-void scan_files() {
+void scan_files(const config_t *cfg) {
+    solver_t *solver = create_solver(cfg); // shared by all inputs
     char input_name[INPUT_FILE_NAME_SIZE];
     char output_name[INPUT_FILE_NAME_SIZE];
+    char front_name[FRONT_NAME_SIZE];
+    char checkpoint_name[CHECKPOINT_NAME_SIZE];
+    char stream_name[STREAM_NAME_SIZE];
+    char delta_name[DELTA_NAME_SIZE];
     int file_found = 0;
     for (int i = 50; i >= 1; i--) {
         sprintf(input_name, "input%d.txt", i);
@@ -1360,19 +5896,621 @@ void scan_files() {
         } else {
             file_found = 1;
             FILE *output = fopen(output_name, "w");
-            solve(input, output);
+            FILE *front = NULL;
+            if (cfg -> write_front) {
+                sprintf(front_name, "ArtemBahanovFront%d.txt", i);
+                front = fopen(front_name, "w");
+            }
+            FILE *stream = NULL;
+            if (cfg -> write_stream) {
+                sprintf(stream_name, "ArtemBahanovStream%d.txt", i);
+                stream = fopen(stream_name, "w");
+            }
+            sprintf(checkpoint_name, "ArtemBahanovCheckpoint%d.bin", i);
+            int invalid = solve(solver, input, output, front, cfg -> checkpoint_seconds > 0 || cfg -> resume ? checkpoint_name : NULL, stream);
+            if (cfg -> profile) print_profile(stderr, input_name);
+            if (stats.lanes) fprintf(stderr, "%s: %s won (lane %lld of %lld), badness %lld\n", input_name,
+                                     strategy_name((int) stats.winner_strategy), stats.winner, stats.lanes, stats.badness);
+            if (stream != NULL) fclose(stream);
+            if (front != NULL) fclose(front);
             fclose(output);
             fclose(input);
+
+            for (int k = 1; cfg -> delta && !invalid; ++k) {
+                sprintf(delta_name, "input%d.delta%d.txt", i, k);
+                FILE *changes = fopen(delta_name, "r");
+                if (changes == NULL) break;
+
+                sprintf(delta_name, "ArtemBahanovOutput%d.delta%d.txt", i, k);
+                output = fopen(delta_name, "w");
+                invalid = solve_delta(solver, changes, output);
+                if (cfg -> profile) {
+                    sprintf(delta_name, "input%d.delta%d.txt", i, k);
+                    print_profile(stderr, delta_name);
+                }
+                fclose(output);
+                fclose(changes);
+            }
+        }
+    }
+
+    solver_free(solver);
+}
+
+#ifdef BENCHMARK
+/*
+ * Randomly generated problem used by benchmarks.
+ */
+typedef struct bench_instance_s {
+    int C;
+    int P;
+    int T;
+    int S;
+    course_t **courses;
+    professor_t **profs;
+    ta_t **tas;
+    roster_t *roster;
+    int **profs_pool;
+    int **tas_pool;
+    int *c_studs;
+} bench_t;
+
+/*
+ * Create a name that consists of letters only: prefix followed by id written in base 26.
+ */
+char *bench_name(const char *prefix, int id) {
+    char *name = malloc(BUFFER_SIZE);
+    int len = (int) strlen(prefix);
+
+    strcpy(name, prefix);
+    do {
+        name[len++] = (char) ('a' + id % 26);
+        id /= 26;
+    } while (id > 0);
+    name[len] = '\0';
+
+    return name;
+}
+
+/*
+ * Create array of at most max_num distinct random course ids. 0-th element is the size.
+ */
+int *bench_courses(int C, int max_num) {
+    int *courses = malloc(sizeof(int) * (MAX_COURSES + 1));
+    int num = randInt(1, max_num + 1);
+
+    courses[0] = 0;
+    for (int i = 0; i < num; ++i) {
+        int course = randInt(0, C);
+        if (!is_in_courses(course, courses)) courses[++courses[0]] = course;
+    }
+
+    return courses;
+}
+
+/*
+ * Generate random instance with given sizes.
+ */
+bench_t *create_bench_instance(int C, int P, int T, int S, unsigned seed) {
+    bench_t *b = malloc(sizeof(bench_t));
+    rng_seed(&rng, seed);
+
+    b -> C = C;
+    b -> P = P;
+    b -> T = T;
+    b -> S = S;
+    b -> courses = malloc(C * sizeof(course_t *));
+    b -> profs = malloc(P * sizeof(professor_t *));
+    b -> tas = malloc(T * sizeof(ta_t *));
+    b -> roster = create_roster();
+
+    for (int i = 0; i < C; ++i) {
+        b -> courses[i] = create_course(i, bench_name("Course", i), randInt(1, 4), randInt(10, 60));
+    }
+    for (int i = 0; i < P; ++i) {
+        b -> profs[i] = create_professor(i, bench_name("Prof ", i), bench_courses(C, 3));
+    }
+    for (int i = 0; i < T; ++i) {
+        b -> tas[i] = create_ta(i, bench_name("Ta ", i), bench_courses(C, 3));
+    }
+    for (int i = 0; i < S; ++i) {
+        char code[STUDENT_CODE_SIZE];
+        char *name = bench_name("Student ", i);
+        int *courses = bench_courses(C, 4);
+
+        sprintf(code, "%05d", i % 100000);
+        roster_begin(b -> roster);
+        roster_put_text(b -> roster, name, strlen(name), '\0');
+        roster_put_code(b -> roster, code);
+        for (int k = 1; k <= courses[0]; ++k) {
+            roster_put_course(b -> roster, courses[k]);
+        }
+        roster_end(b -> roster);
+        free(courses);
+        free(name);
+    }
+
+    b -> tas_pool = create_tas_pool(C, T, b -> tas);
+    b -> profs_pool = create_profs_pool(C, P, b -> profs);
+    b -> c_studs = create_c_studs(C, b -> roster);
+
+    return b;
+}
+
+/*
+ * Free space that was used by benchmark instance.
+ */
+void free_bench_instance(bench_t *b) {
+    for (int i = 0; i < b -> C; ++i) {
+        free(b -> courses[i] -> name);
+        free(b -> courses[i]);
+        free(b -> tas_pool[i]);
+        free(b -> profs_pool[i]);
+    }
+    for (int i = 0; i < b -> P; ++i) {
+        free(b -> profs[i] -> name);
+        free(b -> profs[i] -> courses);
+        free(b -> profs[i]);
+    }
+    for (int i = 0; i < b -> T; ++i) {
+        free(b -> tas[i] -> name);
+        free(b -> tas[i] -> courses);
+        free(b -> tas[i]);
+    }
+
+    free(b -> courses);
+    free(b -> profs);
+    free(b -> tas);
+    free_roster(b -> roster);
+    free(b -> tas_pool);
+    free(b -> profs_pool);
+    free(b -> c_studs);
+    free(b);
+}
+
+/*
+ * Seconds passed since start.
+ */
+double bench_seconds(clock_t start) {
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*
+ * Compare calculate_badness with calculate_badness_batch on the same individuals.
+ */
+void bench_badness(int C, int P, int T, int S) {
+    const int n = 8 * SOA_BLOCK;
+    const int rounds = 20;
+    bench_t *b = create_bench_instance(C, P, T, S, SEED);
+    ind_t **inds = malloc(n * sizeof(ind_t *));
+    soa_t *soa = create_soa(SOA_BLOCK, C, P, T);
+    long long checksum_scalar = 0, checksum_batch = 0;
+
+    for (int j = 0; j < n; ++j) {
+        inds[j] = create_ind(C, P, T, b -> courses, b -> profs, b -> tas, b -> profs_pool, b -> tas_pool);
+    }
+
+    clock_t start = clock();
+    for (int r = 0; r < rounds; ++r) {
+        for (int j = 0; j < n; ++j) {
+            checksum_scalar += calculate_badness(C, P, T, inds[j], b -> c_studs);
+        }
+    }
+    double scalar_time = bench_seconds(start);
+
+    start = clock();
+    for (int r = 0; r < rounds; ++r) {
+        for (int block = 0; block < n; block += SOA_BLOCK) {
+            soa_clear(soa);
+            for (int j = 0; j < SOA_BLOCK; ++j) {
+                soa_store_ind(soa, j, inds[block + j]);
+            }
+            calculate_badness_batch(soa, b -> courses, b -> c_studs);
+            for (int j = 0; j < SOA_BLOCK; ++j) {
+                checksum_batch += soa -> badness[j];
+            }
+        }
+    }
+    double batch_time = bench_seconds(start);
+
+    start = clock();
+    for (int r = 0; r < rounds; ++r) {
+        for (int block = 0; block < n; block += SOA_BLOCK) {
+            calculate_badness_batch(soa, b -> courses, b -> c_studs);
+        }
+    }
+    double kernel_time = bench_seconds(start);
+
+    printf("badness C=%d P=%d T=%d: scalar %.3f us/ind, batch %.3f us/ind (kernel only %.3f us/ind)%s\n",
+           C, P, T,
+           1e6 * scalar_time / rounds / n, 1e6 * batch_time / rounds / n, 1e6 * kernel_time / rounds / n,
+           checksum_scalar == checksum_batch ? "" : " MISMATCH");
+
+    for (int j = 0; j < n; ++j) {
+        free_ind(C, inds[j]);
+    }
+    free(inds);
+    free_soa(soa);
+    free_bench_instance(b);
+}
+
+/*
+ * Compare finding course names in hash table with linear probing and in frozen perfect hash.
+ */
+void bench_names(int C) {
+    const int lookups = 1000000;
+    bench_t *b = create_bench_instance(C, 1, 1, 0, SEED);
+    chash_t *chash = create_courses_hashtable();
+    int *queries = malloc(lookups * sizeof(int));
+    long long checksum_probe = 0, checksum_frozen = 0;
+
+    for (int i = 0; i < C; ++i) {
+        addCourseToHashTable(chash, b -> courses[i]);
+    }
+    for (int k = 0; k < lookups; ++k) {
+        queries[k] = randInt(0, C);
+    }
+
+    clock_t start = clock();
+    for (int k = 0; k < lookups; ++k) {
+        checksum_probe += getCourseIdFromHashTable(chash, b -> courses[queries[k]] -> name);
+    }
+    double probe_time = bench_seconds(start);
+
+    start = clock();
+    freezeCoursesHashTable(chash, C, b -> courses);
+    double freeze_time = bench_seconds(start);
+
+    start = clock();
+    for (int k = 0; k < lookups; ++k) {
+        checksum_frozen += getCourseIdFromHashTable(chash, b -> courses[queries[k]] -> name);
+    }
+    double frozen_time = bench_seconds(start);
+
+    printf("names C=%d: probing %.1f ns/lookup, frozen %.1f ns/lookup (built in %.3f ms)%s\n",
+           C, 1e9 * probe_time / lookups, 1e9 * frozen_time / lookups, 1e3 * freeze_time,
+           checksum_probe == checksum_frozen ? "" : " MISMATCH");
+
+    free_frozen_names(chash -> frozen);
+    free(chash -> courses);
+    free(chash);
+    free(queries);
+    free_bench_instance(b);
+}
+
+/*
+ * Compare allocate_seats with scanning all students for every course, as format_ind did before.
+ */
+void bench_seats(int C, int S) {
+    bench_t *b = create_bench_instance(C, C / 2, C, S, SEED);
+    ind_t *ind = create_ind(C, C / 2, C, b -> courses, b -> profs, b -> tas, b -> profs_pool, b -> tas_pool);
+    long long checksum_scan = 0, checksum_alloc = 0;
+
+    clock_t start = clock();
+    for (int i = 0; i < C; ++i) {
+        if (!ind -> cinds[i] -> runnable) continue;
+
+        int st_num = 0;
+        for (int j = 0; j < S && st_num < b -> courses[i] -> students_number; ++j) {
+            const int *courses = roster_courses(b -> roster, j);
+            int k = 0;
+            for (; k < b -> roster -> count[j] && courses[k] != i; ++k);
+            if (k < b -> roster -> count[j]) {
+                ++st_num;
+                checksum_scan += j;
+            }
+        }
+    }
+    double scan_time = bench_seconds(start);
+
+    start = clock();
+    seats_t *seats = allocate_seats(C, b -> roster, ind);
+    for (int k = 0; k < seats -> offsets[C]; ++k) {
+        checksum_alloc += seats -> seated[k];
+    }
+    double alloc_time = bench_seconds(start);
+
+    printf("seats C=%d S=%d: scan %.3f ms, allocate_seats %.3f ms%s\n",
+           C, S, 1e3 * scan_time, 1e3 * alloc_time, checksum_scan == checksum_alloc ? "" : " MISMATCH");
+
+    free_seats(seats);
+    free_ind(C, ind);
+    free_bench_instance(b);
+}
+
+/*
+ * Compare random search of get_best_sol with exact optimum as CPU time grows.
+ * Prints one line per number of sampled individuals: best badness, CPU time and gap to optimum.
+ */
+void bench_quality(int C, int P, int T, int S, unsigned seed) {
+    bench_t *b = create_bench_instance(C, P, T, S, seed);
+    long long nodes = 0;
+
+    clock_t start = clock();
+    ind_t *exact = get_exact_sol(C, P, T, b -> courses, b -> profs, b -> tas, b -> profs_pool, b -> tas_pool, b -> c_studs, &nodes);
+    double exact_time = bench_seconds(start);
+    printf("quality C=%d P=%d T=%d seed=%u: optimum %d (%lld nodes, %.3f ms)\n",
+           C, P, T, seed, exact -> badness_points, nodes, 1e3 * exact_time);
+
+    int best = MAX_BADNESS_POINTS;
+    long long samples = 0;
+    start = clock();
+    for (long long checkpoint = 10; checkpoint <= 10000; checkpoint *= 10) {
+        for (; samples < checkpoint; ++samples) {
+            ind_t *ind = create_ind(C, P, T, b -> courses, b -> profs, b -> tas, b -> profs_pool, b -> tas_pool);
+            int badness = calculate_badness(C, P, T, ind, b -> c_studs);
+            if (badness < best) best = badness;
+            free_ind(C, ind);
+        }
+        printf("  samples %6lld: cpu %9.3f ms, best %5d, gap %5d (%.2f%%)%s\n",
+               samples, 1e3 * bench_seconds(start), best, best - exact -> badness_points,
+               100.0 * (best - exact -> badness_points) / exact -> badness_points,
+               best < exact -> badness_points ? " BELOW OPTIMUM" : "");
+    }
+
+    free_ind(C, exact);
+    free_bench_instance(b);
+}
+
+/*
+ * Write course names of list (first element is the number of courses) into f.
+ */
+void bench_write_courses(FILE *f, bench_t *b, const int *courses) {
+    for (int k = 1; k <= courses[0]; ++k) {
+        fprintf(f, " %s", b -> courses[courses[k]] -> name);
+    }
+}
+
+/*
+ * Write benchmark instance into f as input file. Input must not end with empty line.
+ */
+void write_bench_input(FILE *f, bench_t *b) {
+    for (int i = 0; i < b -> C; ++i) {
+        fprintf(f, "%s %d %d\n", b -> courses[i] -> name, b -> courses[i] -> labs_number, b -> courses[i] -> students_number);
+    }
+    fprintf(f, "P\n");
+    for (int i = 0; i < b -> P; ++i) {
+        fprintf(f, "%s", b -> profs[i] -> name);
+        bench_write_courses(f, b, b -> profs[i] -> courses);
+        fputc('\n', f);
+    }
+    fprintf(f, "T\n");
+    for (int i = 0; i < b -> T; ++i) {
+        fprintf(f, "%s", b -> tas[i] -> name);
+        bench_write_courses(f, b, b -> tas[i] -> courses);
+        fputc('\n', f);
+    }
+    fprintf(f, "S");
+    for (int i = 0; i < b -> S; ++i) {
+        fprintf(f, "\n%s %s", roster_name(b -> roster, i), roster_code(b -> roster, i));
+        for (int k = 0; k < b -> roster -> count[i]; ++k) {
+            fprintf(f, " %s", b -> courses[roster_courses(b -> roster, i)[k]] -> name);
+        }
+    }
+}
+
+/*
+ * Compare solving the same input runs times with one solver context and with new context every time.
+ */
+void bench_library(int C, int P, int T, int S, int runs) {
+    bench_t *b = create_bench_instance(C, P, T, S, SEED);
+    char *input = NULL;
+    size_t input_size = 0;
+    FILE *f = open_memstream(&input, &input_size);
+
+    write_bench_input(f, b);
+    fclose(f);
+
+    config_t cfg;
+    default_config(&cfg);
+    cfg.population_size = 10; // measure setup, not search
+    cfg.best_size = 2;
+    cfg.kids_size = 4;
+    cfg.mutation_size = 4;
+    cfg.generations_number = 1;
+
+    char *output;
+    size_t output_size;
+    int invalid = 0;
+
+    clock_t start = clock();
+    for (int r = 0; r < runs; ++r) {
+        solver_t *solver = create_solver(&cfg);
+        invalid |= solver_solve_buffer(solver, input, input_size, &output, &output_size);
+        free(output);
+        solver_free(solver);
+    }
+    double fresh_time = bench_seconds(start);
+
+    solver_t *solver = create_solver(&cfg);
+    start = clock();
+    for (int r = 0; r < runs; ++r) {
+        invalid |= solver_solve_buffer(solver, input, input_size, &output, &output_size);
+        free(output);
+    }
+    double reused_time = bench_seconds(start);
+    solver_free(solver);
+
+    printf("library C=%d S=%d: new context %.3f ms/solve, reused context %.3f ms/solve%s\n",
+           C, S, 1e3 * fresh_time / runs, 1e3 * reused_time / runs, invalid ? " INVALID" : "");
+
+    free(input);
+    free_bench_instance(b);
+}
+
+/*
+ * Print time of one call of kernel and checksum of its results.
+ */
+void print_kernel(const char *name, double seconds, long long calls, long long checksum) {
+    printf("kernel %-20s %10.1f ns/call  (checksum %lld)\n", name, 1e9 * seconds / calls, checksum);
+}
+
+/*
+ * Micro-benchmarks of hot kernels on one generated instance.
+ * Checksums must be the same for all build configurations.
+ */
+void bench_kernels(int C, int P, int T, int S) {
+    const int rounds = 200;
+    bench_t *b = create_bench_instance(C, P, T, S, SEED);
+    long long checksum = 0;
+
+    clock_t start = clock();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < S; ++i) {
+            checksum += compressed_hash(roster_name(b -> roster, i));
+        }
+    }
+    print_kernel("compressed_hash", bench_seconds(start), (long long) rounds * S, checksum);
+
+    char *input = NULL;
+    size_t input_size = 0;
+    FILE *f = open_memstream(&input, &input_size);
+    write_bench_input(f, b);
+    fclose(f);
+    for (size_t k = 0; k < input_size; ++k) {
+        if (input[k] == '\n') input[k] = ' ';
+    }
+
+    char *buffer = malloc(BUFFER_SIZE);
+    struct flag_s flag;
+    long long tokens = 0;
+    checksum = 0;
+    start = clock();
+    for (int r = 0; r < rounds / 10; ++r) {
+        char *line = input;
+        do {
+            clearFlag(&flag);
+            line = nextToken(buffer, BUFFER_SIZE, line, &flag);
+            checksum += flag.length + flag.contains_digits;
+            tokens++;
+        } while (!flag.last_token);
+    }
+    print_kernel("nextToken", bench_seconds(start), tokens, checksum);
+    free(buffer);
+    free(input);
+
+    const int n = 64;
+    ind_t **inds = malloc(n * sizeof(ind_t *));
+    for (int j = 0; j < n; ++j) {
+        inds[j] = create_ind(C, P, T, b -> courses, b -> profs, b -> tas, b -> profs_pool, b -> tas_pool);
+    }
+    checksum = 0;
+    start = clock();
+    for (int r = 0; r < rounds; ++r) {
+        for (int j = 0; j < n; ++j) {
+            checksum += calculate_badness(C, P, T, inds[j], b -> c_studs);
         }
     }
+    print_kernel("calculate_badness", bench_seconds(start), (long long) rounds * n, checksum);
+    for (int j = 0; j < n; ++j) {
+        free_ind(C, inds[j]);
+    }
+    free(inds);
+
+    layout_t *layout = create_layout(C, P, T, b -> courses, b -> tas_pool);
+    work_t *work = create_work(C, P, T, b -> tas_pool);
+    unsigned char *genome = malloc(layout -> size + 1);
+    memset(genome, 0xFF, layout -> size);
+    checksum = 0;
+    start = clock();
+    for (int r = 0; r < rounds; ++r) {
+        work_clear(work, P, T);
+        for (int i = 0; i < C; ++i) {
+            if (pool_capacity(i, b -> tas_pool, work -> avail_tas) >= b -> courses[i] -> labs_number) {
+                genome_distr_tas(layout, genome, i, b -> tas_pool, work);
+            }
+        }
+        for (int k = C; k < layout -> genes; ++k) {
+            checksum += gene_get(layout, genome, k);
+        }
+    }
+    print_kernel("genome_distr_tas", bench_seconds(start), (long long) rounds * C, checksum);
+    free(genome);
+
+    cpop_t *pop = create_cpop(layout, POPULATION_SIZE);
+    int *badness = malloc(POPULATION_SIZE * sizeof(int));
+    for (int j = 0; j < POPULATION_SIZE; ++j) {
+        work_clear(work, P, T);
+        distr_genome(layout, cpop_genome(pop, j), P, T, b -> courses, b -> profs, b -> profs_pool, b -> tas_pool, work);
+        badness[j] = randInt(0, 1000000);
+        pop -> hash[j] = genome_hash(layout, cpop_genome(pop, j));
+    }
+    checksum = 0;
+    start = clock();
+    for (int r = 0; r < rounds / 10; ++r) {
+        memcpy(pop -> badness, badness, POPULATION_SIZE * sizeof(int));
+        choose_best_genomes(pop, BEST_SIZE);
+        checksum += pop -> badness[BEST_SIZE - 1];
+    }
+    print_kernel("choose_best_genomes", bench_seconds(start), rounds / 10, checksum);
+
+    free(badness);
+    free_cpop(pop);
+    free_work(work);
+    free_layout(layout);
+    free_bench_instance(b);
+}
+
+/*
+ * Write generated instances into input<k>.txt of current directory, used as training workload of PGO build.
+ */
+void write_training_instances() {
+    int sizes[][4] = {{10, 6, 8, 60}, {30, 20, 25, 300}, {60, 40, 50, 900}, {100, 60, 80, 2000}, {200, 120, 150, 6000}};
+    char name[INPUT_FILE_NAME_SIZE];
+
+    for (int k = 0; k < (int) (sizeof(sizes) / sizeof(sizes[0])); ++k) {
+        bench_t *b = create_bench_instance(sizes[k][0], sizes[k][1], sizes[k][2], sizes[k][3], SEED + k);
+        sprintf(name, "input%d.txt", k + 1);
+        FILE *f = fopen(name, "w");
+        write_bench_input(f, b);
+        fclose(f);
+        free_bench_instance(b);
+    }
 }
 
-int main() {
+/*
+ * Run all benchmarks and print results into standard output.
+ */
+void run_benchmarks() {
+    bench_badness(10, 6, 8, 60);
+    bench_badness(50, 30, 40, 500);
+    bench_badness(100, 60, 80, 1000);
+    bench_names(100);
+    bench_names(1000);
+    bench_names(4000);
+    bench_seats(100, 1000);
+    bench_library(20, 12, 15, 200, 200);
+    bench_library(200, 100, 150, 5000, 20);
+    bench_seats(1000, 10000);
+    bench_seats(1000, 100000);
+    bench_quality(8, 4, 6, 100, 1);
+    bench_quality(12, 8, 5, 200, 2);
+    bench_quality(14, 6, 6, 200, 3);
+    bench_quality(16, 10, 8, 300, 4);
+}
+#endif
+
+#ifndef SOLVER_LIBRARY
+int main(int argc, char **argv) {
+#ifdef BENCHMARK
+    if (argc > 1 && !strcmp(argv[1], "--kernels")) bench_kernels(100, 60, 80, 2000);
+    else if (argc > 1 && !strcmp(argv[1], "--instances")) write_training_instances();
+    else run_benchmarks();
+    return 0;
+#endif
+
+    config_t cfg;
+    default_config(&cfg);
+    if (parse_config(&cfg, argc, argv)) {
+        print_usage(stderr);
+        return 1;
+    }
 
     FILE *email_file = fopen("ArtemBahanovEmail.txt", "w");
     fprintf(email_file, "a.bahanov@innopolis.university");
     fclose(email_file);
 
-    scan_files();
+    scan_files(&cfg);
 
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stddef.h>
+
+/*
+ * Solver of course assignment problems that can be embedded into other programs.
+ * Compile main.c with -DSOLVER_LIBRARY to leave out main().
+ *
+ * A context keeps hash tables, buffers and worker threads between calls.
+ * One context must be used by one thread at a time; different contexts can be used from different threads.
+ */
+typedef struct solver_context_s solver_t;
+
+/*
+ * Create context with options given as on command line (argv[0] is skipped), e.g. "--generations=20".
+ * Returns NULL if options are wrong.
+ */
+solver_t *solver_create(int argc, char **argv);
+
+/*
+ * Solve problem given as text of input file (input_size bytes, does not have to end with zero).
+ * Text of output file is written into new buffer *output of *output_size bytes, ended by zero;
+ * caller frees it with free().
+ * Returns 0 if input is valid, 1 if it is not (output is "Invalid input."), -1 if buffers cannot be opened.
+ */
+int solver_solve_buffer(solver_t *solver, const char *input, size_t input_size, char **output, size_t *output_size);
+
+/*
+ * Apply change list of students to the last valid problem solved by solver_solve_buffer,
+ * re-optimize its schedule locally and write the new output as solver_solve_buffer does.
+ * Every line of change list is one of:
+ *   new Name Surname CODE Course...  - new student
+ *   add CODE Course...               - enroll student into courses
+ *   drop CODE Course...              - remove courses of student
+ *   remove CODE                      - remove all courses of student
+ * Change lists can be applied one after another. Returns 1 if change list is invalid or there is no problem
+ * to change; after that, the problem must be solved again.
+ */
+int solver_apply_delta(solver_t *solver, const char *changes, size_t changes_size, char **output, size_t *output_size);
+
+/*
+ * Free context and stop its worker threads.
+ */
+void solver_free(solver_t *solver);
+
+#endif